@@ -1,6 +1,7 @@
 #include "SDL_thread.h"
 #include "platform.h"
 #include "assets.h"
+#include "lerp.h"
 
 #define STBI_NO_STDIO
 #define STB_IMAGE_IMPLEMENTATION
@@ -40,6 +41,11 @@ typedef struct Game_Assets {
 		SDL_Texture_Node table[16];
 		SDL_mutex* mutex;
 	} textures;
+	struct {
+		Atlas_Region_Node table[16];
+		SDL_mutex* mutex;
+	} atlas_regions;
+	Sprite_Chunks* sprite_chunks; // Only used from the main thread
 } Game_Assets;
 
 #define define_store_asset(type, table_name, func_suffix) void assets_store_##func_suffix(Game_Assets* assets, type* asset, const char* label) {\
@@ -160,6 +166,206 @@ STBTTF_Font* load_stbtt_font(const char* file_name, float font_size) {
 	return result;
 }
 
+// Pack glyph rects into the smallest power of two square that fits them all. Returns its size,
+// and the height actually used through used_height if it's not null.
+static int pack_font_rects(stbrp_rect* rects, int count, int* used_height) {
+	int result = 32;
+	stbrp_node* nodes = 0;
+
+	while(1) {
+		nodes = SDL_realloc(nodes, sizeof(stbrp_node) * result);
+		stbrp_context context;
+		stbrp_init_target(&context, result, result, nodes, result);
+		if (stbrp_pack_rects(&context, rects, count)) {
+			break;
+		}
+		result *= 2;
+	}
+	SDL_free(nodes);
+
+	if (used_height) {
+		*used_height = 0;
+		for (int i = 0; i < count; i++) {
+			*used_height = SDL_max(*used_height, rects[i].y + rects[i].h);
+		}
+	}
+
+	return result;
+}
+
+static SDL_Texture* create_font_texture(unsigned char* coverage, int width, int height) {
+	SDL_Texture* result = platform_create_texture(width, height, false);
+
+	Uint32* pixels = SDL_malloc(width * height * sizeof(Uint32));
+	static SDL_PixelFormat* format = 0;
+	if(format == 0) format = SDL_AllocFormat(SDL_PIXELFORMAT_RGBA32);
+	for (int i = 0; i < width * height; i++) {
+		pixels[i] = SDL_MapRGBA(format, 0xff, 0xff, 0xff, coverage[i]);
+	}
+	SDL_UpdateTexture(result, 0, pixels, width * sizeof(Uint32));
+	SDL_free(pixels);
+
+	return result;
+}
+
+// Load a font in SDF mode. Distance fields are baked once at font_size, which can be much smaller than the
+// text drawn with it, and kept in memory instead of a texture. get_stbtt_font_page resolves them for each size drawn.
+STBTTF_Font* load_stbtt_sdf_font(const char* file_name, float font_size) {
+	STBTTF_Font* result = 0;
+
+	size_t file_size = 0;
+	unsigned char* file_buffer = SDL_LoadFile(file_name, &file_size);
+	if (file_buffer == NULL) return result;
+
+	result = SDL_calloc(sizeof(STBTTF_Font), 1);
+	result->info = SDL_malloc(sizeof(stbtt_fontinfo));
+	result->chars = SDL_calloc(96, sizeof(stbtt_packedchar));
+	result->size = font_size;
+
+	if (stbtt_InitFont(result->info, file_buffer, 0) == 0) {
+		SDL_free(file_buffer);
+		SDL_free(result->info);
+		SDL_free(result->chars);
+		SDL_free(result);
+
+		result = 0;
+		return result;
+	}
+	result->scale = stbtt_ScaleForPixelHeight(result->info, font_size);
+
+	unsigned char* glyphs[95];
+	stbrp_rect rects[95];
+	for (int i = 0; i < array_length(glyphs); i++) {
+		int w = 0, h = 0, xoff = 0, yoff = 0, advance = 0;
+		glyphs[i] = stbtt_GetCodepointSDF(result->info, result->scale, 32 + i, STBTTF_SDF_PADDING,
+				STBTTF_SDF_ONEDGE, STBTTF_SDF_PIXEL_DIST_SCALE, &w, &h, &xoff, &yoff);
+		if (glyphs[i] == NULL) w = h = 0;
+		stbtt_GetCodepointHMetrics(result->info, 32 + i, &advance, 0);
+
+		// Keep a pixel between glyphs so resolving one never samples its neighbour
+		rects[i] = (stbrp_rect){ .id = i, .w = w + 1, .h = h + 1 };
+		result->chars[i] = (stbtt_packedchar){
+			.xoff = (float)xoff, .yoff = (float)yoff,
+			.xoff2 = (float)(xoff + w), .yoff2 = (float)(yoff + h),
+			.xadvance = (float)advance * result->scale,
+		};
+	}
+
+	result->texture_size = pack_font_rects(rects, array_length(rects), 0);
+	result->sdf = SDL_calloc(result->texture_size, result->texture_size);
+
+	for (int i = 0; i < array_length(glyphs); i++) {
+		stbtt_packedchar* info = &result->chars[i];
+		info->x0 = rects[i].x;
+		info->y0 = rects[i].y;
+		info->x1 = rects[i].x + rects[i].w - 1;
+		info->y1 = rects[i].y + rects[i].h - 1;
+
+		int w = info->x1 - info->x0;
+		for (int y = 0; y < info->y1 - info->y0; y++) {
+			SDL_memcpy(result->sdf + (info->y0 + y) * result->texture_size + info->x0, glyphs[i] + y * w, w);
+		}
+		if (glyphs[i]) stbtt_FreeSDF(glyphs[i], 0);
+	}
+
+	stbtt_GetFontVMetrics(result->info, &result->ascent, 0, 0);
+	result->baseline = (int) (result->ascent * result->scale);
+
+	SDL_free(file_buffer);
+
+	return result;
+}
+
+// Distance of the distance field at x,y in pixels of the baked size, interpolated between the nearest texels
+static float sample_font_sdf(STBTTF_Font* font, stbtt_packedchar* info, float x, float y) {
+	int w = info->x1 - info->x0, h = info->y1 - info->y0;
+	x = SDL_clamp(x, 0.0f, (float)(w - 1));
+	y = SDL_clamp(y, 0.0f, (float)(h - 1));
+
+	int x0 = (int)x, y0 = (int)y;
+	int x1 = SDL_min(x0 + 1, w - 1), y1 = SDL_min(y0 + 1, h - 1);
+	float tx = x - (float)x0, ty = y - (float)y0;
+
+	unsigned char* row0 = font->sdf + (info->y0 + y0) * font->texture_size + info->x0;
+	unsigned char* row1 = font->sdf + (info->y0 + y1) * font->texture_size + info->x0;
+	float top = lerp((float)row0[x0], (float)row0[x1], tx);
+	float bottom = lerp((float)row1[x0], (float)row1[x1], tx);
+
+	float result = (lerp(top, bottom, ty) - (float)STBTTF_SDF_ONEDGE) / STBTTF_SDF_PIXEL_DIST_SCALE;
+	return result;
+}
+
+// Rasterize every glyph at size from the distance field. Edges get a one pixel ramp at the new size
+// so they stay sharp however far size is from the baked size.
+static STBTTF_Font_Page* build_stbtt_font_page(STBTTF_Font* font, float size) {
+	STBTTF_Font_Page* result = SDL_calloc(1, sizeof(STBTTF_Font_Page));
+	result->chars = SDL_calloc(96, sizeof(stbtt_packedchar));
+	result->size = size;
+
+	float scale = size / font->size;
+	stbrp_rect rects[95];
+	for (int i = 0; i < array_length(rects); i++) {
+		stbtt_packedchar* info = &font->chars[i];
+		int w = 0, h = 0;
+		if (info->x1 > info->x0 && info->y1 > info->y0) {
+			w = (int)SDL_ceilf((float)(info->x1 - info->x0) * scale);
+			h = (int)SDL_ceilf((float)(info->y1 - info->y0) * scale);
+		}
+		rects[i] = (stbrp_rect){ .id = i, .w = w + 1, .h = h + 1 };
+	}
+
+	result->texture_w = pack_font_rects(rects, array_length(rects), &result->texture_h);
+	unsigned char* coverage = SDL_calloc(result->texture_w, result->texture_h);
+
+	for (int i = 0; i < array_length(rects); i++) {
+		stbtt_packedchar* info = &font->chars[i];
+		int w = rects[i].w - 1, h = rects[i].h - 1;
+
+		for (int y = 0; y < h; y++) {
+			unsigned char* row = coverage + (rects[i].y + y) * result->texture_w + rects[i].x;
+			for (int x = 0; x < w; x++) {
+				float distance = sample_font_sdf(font, info, ((float)x + 0.5f) / scale - 0.5f, ((float)y + 0.5f) / scale - 0.5f);
+				float alpha = SDL_clamp(distance * scale + 0.5f, 0.0f, 1.0f);
+				row[x] = (unsigned char)(alpha * 255.0f + 0.5f);
+			}
+		}
+
+		result->chars[i] = (stbtt_packedchar){
+			.x0 = rects[i].x, .y0 = rects[i].y,
+			.x1 = rects[i].x + w, .y1 = rects[i].y + h,
+			.xoff = info->xoff * scale, .yoff = info->yoff * scale,
+			.xoff2 = info->xoff2 * scale, .yoff2 = info->yoff2 * scale,
+			.xadvance = info->xadvance * scale,
+		};
+	}
+
+	result->atlas = create_font_texture(coverage, result->texture_w, result->texture_h);
+	SDL_free(coverage);
+
+	return result;
+}
+
+// The page to draw an SDF font at size from. Sizes are grouped in steps of STBTTF_FONT_PAGE_STEP,
+// and each page is resolved at the top of its step so text is only ever slightly minified.
+STBTTF_Font_Page* get_stbtt_font_page(STBTTF_Font* font, float size) {
+	STBTTF_Font_Page* result = 0;
+	if (font->sdf == NULL) return result;
+
+	int index = 0;
+	float page_size = STBTTF_FONT_MIN_PAGE_SIZE;
+	while (page_size < size && index < STBTTF_FONT_MAX_PAGES - 1) {
+		page_size *= STBTTF_FONT_PAGE_STEP;
+		index++;
+	}
+
+	if (font->pages[index] == NULL) {
+		font->pages[index] = build_stbtt_font_page(font, page_size);
+	}
+	result = font->pages[index];
+
+	return result;
+}
+
 // djb2 hash function
 Uint64 str_hash(unsigned char* str) {
 	Uint64 result = 5381;
@@ -237,6 +443,7 @@ Game_Assets* new_game_assets(void) {
 	result->music.mutex = SDL_CreateMutex();
 	result->textures.mutex = SDL_CreateMutex();
 	result->sfx.mutex = SDL_CreateMutex();
+	result->atlas_regions.mutex = SDL_CreateMutex();
 
 	return result;
 }
@@ -244,6 +451,7 @@ Game_Assets* new_game_assets(void) {
 define_store_asset(SDL_Texture, textures, texture)
 define_store_asset(Mix_Music, music, music)
 define_store_asset(Mix_Chunk, sfx, sfx)
+define_store_asset(Atlas_Region, atlas_regions, atlas_region)
 
 typedef struct asset_load_data {
 	Game_Assets* assets;
@@ -323,62 +531,220 @@ SDL_bool assets_load_sfx(Game_Assets* assets, const char* file, const char* name
 define_get_asset(Mix_Music, music, music)
 define_get_asset(Mix_Chunk, sfx, sfx)
 define_get_asset(SDL_Texture, textures, texture)
+define_get_asset(Atlas_Region, atlas_regions, atlas_region)
 
-Rectangle get_sprite_rect(Game_Assets* assets, Game_Sprite* sprite) {
+// Copy each texture into a render target page, then read it back into a static texture
+// (like the generated item textures) so the page survives renderer resets
+static SDL_Texture* create_atlas_page(SDL_Texture_Node** nodes, stbrp_rect* rects, int count, int w, int h) {
+	SDL_Texture* result = 0;
+
+	SDL_Texture* target = platform_create_texture(w, h, SDL_TRUE);
+	if (target) {
+		platform_set_render_target(target);
+		platform_set_render_draw_color((RGBA_Color){0});
+		platform_render_clear();
+
+		for (int i = 0; i < count; i++) {
+			SDL_Texture* texture = nodes[rects[i].id]->data;
+			Vector2 dim = platform_get_texture_dimensions(texture);
+			Rectangle dest = {
+				(float)(rects[i].x + TEXTURE_ATLAS_PADDING/2),
+				(float)(rects[i].y + TEXTURE_ATLAS_PADDING/2),
+				dim.x, dim.y,
+			};
+
+			// Replace the page's pixels, with the texture's color and alpha mods baked in
+			SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_NONE);
+			platform_render_copy(texture, NULL, &dest, 0, 0, SDL_FLIP_NONE);
+		}
+
+		Uint32 format;
+		SDL_QueryTexture(target, &format, 0, 0, 0);
+		SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0, w, h, 32, format);
+		platform_render_read_pixels(0, format, surface->pixels, surface->pitch);
+
+		result = platform_create_texture_from_surface(surface);
+
+		platform_set_render_target(0);
+		platform_destroy_texture(target);
+		SDL_FreeSurface(surface);
+	}
+
+	return result;
+}
+
+int assets_build_texture_atlas(Game_Assets* assets, int page_size) {
+	int result = 0;
+
+	int count = 0;
+	for (int i = 0; i < array_length(assets->textures.table); i++) {
+		for (SDL_Texture_Node* node = &assets->textures.table[i]; node; node = node->next) {
+			if (node->data && !assets_get_atlas_region(assets, node->name)) count++;
+		}
+	}
+	if (count == 0) return result;
+
+	SDL_Texture_Node** nodes = SDL_malloc(sizeof(SDL_Texture_Node*) * count);
+	stbrp_rect* rects = SDL_malloc(sizeof(stbrp_rect) * count);
+	stbrp_node* pack_nodes = SDL_malloc(sizeof(stbrp_node) * page_size);
+
+	count = 0;
+	for (int i = 0; i < array_length(assets->textures.table); i++) {
+		for (SDL_Texture_Node* node = &assets->textures.table[i]; node; node = node->next) {
+			if (node->data && !assets_get_atlas_region(assets, node->name)) {
+				Vector2 dim = platform_get_texture_dimensions(node->data);
+				rects[count] = (stbrp_rect){
+					.id = count,
+					.w = (int)dim.x + TEXTURE_ATLAS_PADDING,
+					.h = (int)dim.y + TEXTURE_ATLAS_PADDING,
+				};
+				nodes[count++] = node;
+			}
+		}
+	}
+
+	// Fill a page at a time with whatever still fits until everything is packed
+	int remaining = count;
+	while (remaining) {
+		stbrp_context context;
+		stbrp_init_target(&context, page_size, page_size, pack_nodes, page_size);
+		stbrp_pack_rects(&context, rects, remaining);
+
+		// Move the packed rects to the front and trim the page to them
+		int packed = 0;
+		int page_w = 0, page_h = 0;
+		for (int i = 0; i < remaining; i++) {
+			if (rects[i].was_packed) {
+				page_w = SDL_max(page_w, rects[i].x + rects[i].w);
+				page_h = SDL_max(page_h, rects[i].y + rects[i].h);
+
+				stbrp_rect swap = rects[packed];
+				rects[packed++] = rects[i];
+				rects[i] = swap;
+			}
+		}
+		if (packed == 0) {
+			SDL_Log("assets_build_texture_atlas(): %i textures too large for a %ix%i page", remaining, page_size, page_size);
+			break;
+		}
+
+		SDL_Texture* page = create_atlas_page(nodes, rects, packed, page_w, page_h);
+		if (page == NULL) {
+			SDL_Log("assets_build_texture_atlas(): Failed to create page. %s", SDL_GetError());
+			break;
+		}
+		result++;
+
+		for (int i = 0; i < packed; i++) {
+			SDL_Texture_Node* node = nodes[rects[i].id];
+			Vector2 dim = platform_get_texture_dimensions(node->data);
+
+			Atlas_Region* region = SDL_malloc(sizeof(Atlas_Region));
+			region->page = page;
+			region->rect = (Rectangle){
+				(float)(rects[i].x + TEXTURE_ATLAS_PADDING/2),
+				(float)(rects[i].y + TEXTURE_ATLAS_PADDING/2),
+				dim.x, dim.y,
+			};
+			assets_store_atlas_region(assets, region, node->name);
+
+			platform_destroy_texture(node->data);
+			node->data = page;
+		}
+
+		remaining -= packed;
+		SDL_memmove(rects, rects+packed, sizeof(stbrp_rect) * remaining);
+	}
+
+	SDL_free(pack_nodes);
+	SDL_free(rects);
+	SDL_free(nodes);
+
+	return result;
+}
+
+// The named texture's rect in its atlas page, or the whole texture if it wasn't packed
+Rectangle assets_get_texture_rect(Game_Assets* assets, const char* name) {
 	Rectangle result = {0};
 
-	if (sprite->src_rect.w && sprite->src_rect.h) {
-		result = sprite->src_rect;
+	Atlas_Region* region = assets_get_atlas_region(assets, name);
+	if (region) {
+		result = region->rect;
 	} else {
-		SDL_Texture* texture = 0;
-		if (sprite->texture_name) {
-			texture = assets_get_texture(assets, sprite->texture_name);
-		}
-		
+		SDL_Texture* texture = assets_get_texture(assets, name);
 		if (texture) {
 			int w,h;
 			SDL_QueryTexture(texture, NULL, NULL, &w, &h);
 			result.w = (float)w;
 			result.h = (float)h;
 		}
-		else SDL_Log("get_sprite_rect(): Invalid texture.");
 	}
 
 	return result;
 }
 
-// Currently allocates an array of Game_Sprites of length pieces.
-// Should be freed after use.
-Game_Sprite* divide_sprite(Game_Assets* assets, Game_Sprite* sprite, int pieces) {
-	Game_Sprite* result = 0;
-	
-	if (sprite && pieces > 0) {
-		int columns = 2;
-		int rows = pieces / columns;
+// A sprite's src_rect is relative to its texture, so it's offset into the atlas page when the texture was packed
+Rectangle get_sprite_rect(Game_Assets* assets, Game_Sprite* sprite) {
+	Rectangle result = {0};
 
-		result = SDL_malloc(sizeof(Game_Sprite) * (pieces));
-		
-		Rectangle sprite_rect = get_sprite_rect(assets, sprite);
-		
-		int chunk_width =  (int)(sprite_rect.w / columns);
-		int chunk_height = (int)(sprite_rect.h / rows);
-
-		int next_sprite = 0;
-		for (int e = 0; e < rows; e++) {
-			for (int i = 0; i < columns; i++) {
-				Game_Sprite* chunk = result + next_sprite;
-
-				chunk->texture_name = sprite->texture_name;
-				chunk->src_rect.x  = chunk_width  * i;
-				chunk->src_rect.y  = chunk_height * e;
-				chunk->src_rect.w  = chunk_width;
-				chunk->src_rect.h  = chunk_height;
-				chunk->offset.x = chunk->offset.y = 0;
-			
-				next_sprite++;
-			}
+	Rectangle texture_rect = assets_get_texture_rect(assets, sprite->texture_name);
+	if (sprite->src_rect.w && sprite->src_rect.h) {
+		result = translate_rect(sprite->src_rect, (Vector2){texture_rect.x, texture_rect.y});
+	} else if (texture_rect.w && texture_rect.h) {
+		result = texture_rect;
+	}
+	else SDL_Log("get_sprite_rect(): Invalid texture.");
+
+	return result;
+}
+
+// Get sprite divided into 2 columns of pieces/2 rows. The table is built on the first request
+// for a sprite and piece count, then reused, so callers shouldn't free or modify it.
+Sprite_Chunks* get_sprite_chunks(Game_Assets* assets, Game_Sprite* sprite, int pieces) {
+	Sprite_Chunks* result = 0;
+	if (sprite == NULL || sprite->texture_name == NULL || pieces < 2) return result;
+
+	for (Sprite_Chunks* chunks = assets->sprite_chunks; chunks; chunks = chunks->next) {
+		if (	chunks->pieces == pieces
+			&& SDL_memcmp(&chunks->src_rect, &sprite->src_rect, sizeof(Rectangle)) == 0
+			&& (chunks->texture_name == sprite->texture_name || SDL_strcmp(chunks->texture_name, sprite->texture_name) == 0)
+		) {
+			result = chunks;
+			return result;
 		}
 	}
 
+	SDL_Texture* texture = assets_get_texture(assets, sprite->texture_name);
+	if (texture == NULL) return result;
+
+	int columns = 2;
+	int rows = pieces / columns;
+	Rectangle sprite_rect = get_sprite_rect(assets, sprite);
+	
+	int chunk_width =  (int)(sprite_rect.w / columns);
+	int chunk_height = (int)(sprite_rect.h / rows);
+
+	result = SDL_calloc(1, sizeof(Sprite_Chunks));
+	result->texture_name = sprite->texture_name;
+	result->src_rect = sprite->src_rect;
+	result->pieces = pieces;
+	result->texture = texture;
+	result->count = rows * columns;
+	result->rects = SDL_malloc(sizeof(Rectangle) * result->count);
+
+	for (int e = 0; e < rows; e++) {
+		for (int i = 0; i < columns; i++) {
+			result->rects[e * columns + i] = (Rectangle) {
+				sprite_rect.x + chunk_width * i,
+				sprite_rect.y + chunk_height * e,
+				chunk_width,
+				chunk_height,
+			};
+		}
+	}
+
+	result->next = assets->sprite_chunks;
+	assets->sprite_chunks = result;
+
 	return result;
 }
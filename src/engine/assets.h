@@ -20,9 +20,40 @@ declare_store_asset		(Mix_Music, music);
 declare_store_asset		(Mix_Chunk, sfx);
 declare_store_asset		(SDL_Texture, texture);
 
+#define TEXTURE_ATLAS_PAGE_SIZE 1024
+#define TEXTURE_ATLAS_PADDING 2 // Transparent pixels between packed textures so filtering doesn't bleed
+
+// Pack every stored texture into as few shared pages as possible so draws from different textures
+// can batch. Afterwards assets_get_texture returns a texture's page and assets_get_texture_rect
+// where the texture is within it. Returns the number of pages created.
+int assets_build_texture_atlas	(Game_Assets* assets, int page_size);
+Rectangle assets_get_texture_rect(Game_Assets* assets, const char* name);
+
+// A sprite's source rect divided into a grid of pieces, built once and cached by get_sprite_chunks
+typedef struct Sprite_Chunks {
+	const char* texture_name;
+	Rectangle src_rect; // The divided sprite's src_rect, all zero for the whole texture
+	int pieces;
+
+	SDL_Texture* texture;
+	Rectangle* rects;
+	int count;
+
+	struct Sprite_Chunks* next;
+} Sprite_Chunks;
+
 Rectangle get_sprite_rect	(Game_Assets* assets, Game_Sprite* sprite);
-Game_Sprite* divide_sprite	(Game_Assets* assets, Game_Sprite* sprite, int pieces);
+Sprite_Chunks* get_sprite_chunks(Game_Assets* assets, Game_Sprite* sprite, int pieces);
 
 STBTTF_Font* load_stbtt_font	(const char* file_name, float font_size);
 
+#define STBTTF_SDF_PADDING 4 // Pixels of distance field around each glyph at the baked size
+#define STBTTF_SDF_ONEDGE 128
+#define STBTTF_SDF_PIXEL_DIST_SCALE (128.0f / (float)STBTTF_SDF_PADDING)
+#define STBTTF_FONT_MIN_PAGE_SIZE 8.0f
+#define STBTTF_FONT_PAGE_STEP 1.4142136f // Two pages per doubling of the text size
+
+STBTTF_Font* load_stbtt_sdf_font	(const char* file_name, float font_size);
+STBTTF_Font_Page* get_stbtt_font_page	(STBTTF_Font* font, float size);
+
 #endif
@@ -33,6 +33,14 @@ bool sc2d_check_poly2d(	float p1x, float p1y, float* p1_verts, int p1_count,
 			float p2x, float p2y, float* p2_verts, int p2_count, 
 			float* overlap_x, float* overlap_y);
 
+bool sc2d_check_poly2d_normals(float p1x, float p1y, float* p1_verts, float* p1_normals, int p1_count, 
+			       float p2x, float p2y, float* p2_verts, float* p2_normals, int p2_count, 
+			       float* overlap_x, float* overlap_y);
+
+bool sc2d_check_circle_poly2d(float cx, float cy, float cr,
+			      float px, float py, float* poly_verts, float* poly_normals, int poly_count,
+			      float* overlap_x, float* overlap_y);
+
 bool sc2d_check_point_poly2d(float px, float py, float* poly_verts, int vert_count);
 bool sc2d_check_point_line(float px, float py, float start_x, float start_y, float end_x, float end_y, bool segment);
 
@@ -247,6 +255,34 @@ static void v2_normalize(float* x, float* y) {
 	*y /= magnitude;
 }
 
+// Project both polygons onto a unit axis and keep the axis if it has the smallest overlap so far.
+// Returns false if the projections are separated.
+static inline bool sc2d_check_poly2d_axis(float axis_x, float axis_y, float delta_x, float delta_y,
+					  float* p1_verts, int p1_count, float* p2_verts, int p2_count,
+					  float* min_distance, float* overlap_x, float* overlap_y) {
+	float p1_min, p1_max, p2_min, p2_max;
+	float offset = (axis_x * delta_x) + (axis_y * delta_y); // project the the vector between polygon positions to the axis (dot product)
+
+	project_poly2d_to_axis(axis_x, axis_y, p1_verts, p1_count, &p1_min, &p1_max); // project every vertex in first polygon to current axis
+	project_poly2d_to_axis(axis_x, axis_y, p2_verts, p2_count, &p2_min, &p2_max); // project every vertex in second polygon to current axis
+	
+	p1_min -= offset; // Add position offset to projection
+	p1_max -= offset;
+	
+	if ( (p1_min > p2_max) || (p1_max < p2_min)) { // If the ranges do not overlap, polygons are not touching
+		return false;
+	}
+	
+	float distance = sc2d_min(p1_max, p2_max) - sc2d_max(p1_min, p2_min);
+	if (distance < *min_distance) { // Update minimum distance for overlap
+		*min_distance = distance;
+		*overlap_x = axis_x * (float)(1 - 2 * (int)(offset < 0) );
+		*overlap_y = axis_y * (float)(1 - 2 * (int)(offset < 0) );
+	}
+
+	return true;
+}
+
 // Check for collision between two convex polygons and return shortest axis overlap by reference
 // p1_count and p2_count: The number of x/y pairs (or custom sc2d_v2 structs) in poly_verts
 //
@@ -261,13 +297,10 @@ bool sc2d_check_poly2d(	float p1x, float p1y, float* p1_verts, int p1_count,
 						float p2x, float p2y, float* p2_verts, int p2_count, 
 						float* overlap_x, float* overlap_y) {
 	
-	bool result = true;
-	float p1_min, p1_max, p2_min, p2_max;
 	float axis_x, axis_y;
 
 	float delta_x = p2x - p1x;
 	float delta_y = p2y - p1y;
-	float offset = 0;
 	float min_distance = INFINITY;
 
 	// First polygon
@@ -275,24 +308,10 @@ bool sc2d_check_poly2d(	float p1x, float p1y, float* p1_verts, int p1_count,
 		get_poly2d_edge(p1_verts, p1_count, i, &axis_x, &axis_y); // Get vector pointing from curent vertex to next vertex (edge)
 		v2_normal(&axis_x, &axis_y, false); // Get the normal of the edge (vector perpendicular to the edge)
 		v2_normalize(&axis_x, &axis_y);
-		offset = (axis_x * delta_x) + (axis_y * delta_y); // project the the vector between polygon positions to the axis (dot product)
-
-		project_poly2d_to_axis(axis_x, axis_y, p1_verts, p1_count, &p1_min, &p1_max); // project ever y vertex in first polygon to current axis
-		project_poly2d_to_axis(axis_x, axis_y, p2_verts, p2_count, &p2_min, &p2_max); // project ever y vertex in scond polygon to current axis
-		
-		p1_min -= offset; // Add position offset to projection
-		p1_max -= offset;
-		
-		if ( (p1_min > p2_max) || (p1_max < p2_min)) { // If the ranges do not overlap, polygons are not touching
+
+		if (!sc2d_check_poly2d_axis(axis_x, axis_y, delta_x, delta_y, p1_verts, p1_count, p2_verts, p2_count, &min_distance, overlap_x, overlap_y)) {
 			return false;
 		}
-		
-		float distance = sc2d_min(p1_max, p2_max) - sc2d_max(p1_min, p2_min);
-		if (distance < min_distance) { // Update minimum distance for overlap
-			min_distance = distance;
-			*overlap_x = axis_x * (float)(1 - 2 * (int)(offset < 0) );
-			*overlap_y = axis_y * (float)(1 - 2 * (int)(offset < 0) );
-		}
 	}
 
 	// Project all vertices to all axes of the second polygon
@@ -300,19 +319,107 @@ bool sc2d_check_poly2d(	float p1x, float p1y, float* p1_verts, int p1_count,
 		get_poly2d_edge(p2_verts, p2_count, i, &axis_x, &axis_y);
 		v2_normal(&axis_x, &axis_y, false);
 		v2_normalize(&axis_x, &axis_y);
+
+		if (!sc2d_check_poly2d_axis(axis_x, axis_y, delta_x, delta_y, p1_verts, p1_count, p2_verts, p2_count, &min_distance, overlap_x, overlap_y)) {
+			return false;
+		}
+	}
+
+	*overlap_x *= min_distance;
+	*overlap_y *= min_distance;
+
+	return true;
+}
+
+// Same as sc2d_check_poly2d, but with the unit edge normals of each polygon supplied by the caller
+// (one x/y pair per edge, where edge i runs from vertex i to vertex i+1).
+// Lets callers that test the same polygon many times compute its normals once.
+bool sc2d_check_poly2d_normals(float p1x, float p1y, float* p1_verts, float* p1_normals, int p1_count, 
+			       float p2x, float p2y, float* p2_verts, float* p2_normals, int p2_count, 
+			       float* overlap_x, float* overlap_y) {
+	float delta_x = p2x - p1x;
+	float delta_y = p2y - p1y;
+	float min_distance = INFINITY;
+
+	for (int i = 0; i < p1_count; i++) {
+		if (!sc2d_check_poly2d_axis(p1_normals[i*2], p1_normals[i*2+1], delta_x, delta_y, p1_verts, p1_count, p2_verts, p2_count, &min_distance, overlap_x, overlap_y)) {
+			return false;
+		}
+	}
+
+	for (int i = 0; i < p2_count; i++) {
+		if (!sc2d_check_poly2d_axis(p2_normals[i*2], p2_normals[i*2+1], delta_x, delta_y, p1_verts, p1_count, p2_verts, p2_count, &min_distance, overlap_x, overlap_y)) {
+			return false;
+		}
+	}
+
+	*overlap_x *= min_distance;
+	*overlap_y *= min_distance;
+
+	return true;
+}
+
+// Check for collision between circle and convex polygon and return shortest axis overlap by reference
+// Tests the polygon's edge normals and the axis from the circle center to the nearest vertex,
+// so the circle does not need to be approximated by a polygon.
+// poly_normals: Optional unit edge normals as in sc2d_check_poly2d_normals, or NULL to compute them
+bool sc2d_check_circle_poly2d(float cx, float cy, float cr,
+			      float px, float py, float* poly_verts, float* poly_normals, int poly_count,
+			      float* overlap_x, float* overlap_y) {
+#ifndef SIMPLE_COLLISION_2D_VECTOR2
+	typedef struct sc2d_v2 {float x, y;} sc2d_v2;
+#endif
+	sc2d_v2* v2_verts = (sc2d_v2*)poly_verts;
+
+	float p_min, p_max;
+	float axis_x, axis_y;
+
+	float delta_x = px - cx;
+	float delta_y = py - cy;
+	float offset = 0;
+	float min_distance = INFINITY;
+
+	// Find the vertex nearest to the circle center for the extra axis
+	int nearest = 0;
+	float nearest_distance = INFINITY;
+	for (int i = 0; i < poly_count; i++) {
+		float vx = delta_x + v2_verts[i].x;
+		float vy = delta_y + v2_verts[i].y;
+		float distance = (vx * vx) + (vy * vy);
+		if (distance < nearest_distance) {
+			nearest_distance = distance;
+			nearest = i;
+		}
+	}
+
+	for (int i = 0; i <= poly_count; i++) {
+		if (i < poly_count && poly_normals) {
+			axis_x = poly_normals[i*2];
+			axis_y = poly_normals[i*2+1];
+		} else {
+			if (i < poly_count) {
+				get_poly2d_edge(poly_verts, poly_count, i, &axis_x, &axis_y);
+				v2_normal(&axis_x, &axis_y, false);
+			} else {
+				axis_x = delta_x + v2_verts[nearest].x;
+				axis_y = delta_y + v2_verts[nearest].y;
+				if (axis_x == 0 && axis_y == 0) continue;
+			}
+			v2_normalize(&axis_x, &axis_y);
+		}
 		offset = (axis_x * delta_x) + (axis_y * delta_y);
 
-		project_poly2d_to_axis(axis_x, axis_y, p1_verts, p1_count, &p1_min, &p1_max);
-		project_poly2d_to_axis(axis_x, axis_y, p2_verts, p2_count, &p2_min, &p2_max);
-		
-		p1_min -= offset;
-		p1_max -= offset;
-		
-		if ( (p1_min > p2_max) || (p1_max < p2_min)) {
+		project_poly2d_to_axis(axis_x, axis_y, poly_verts, poly_count, &p_min, &p_max);
+
+		// Circle projects to [-cr, cr] around its own center
+		p_min += offset;
+		p_max += offset;
+
+		if ( (-cr > p_max) || (cr < p_min)) {
 			return false;
 		}
 
-		float distance = sc2d_min(p1_max, p2_max) - sc2d_max(p1_min, p2_min);
+		float distance = sc2d_min(cr, p_max) - sc2d_max(-cr, p_min);
 		if (distance < min_distance) {
 			min_distance = distance;
 			*overlap_x = axis_x * (float)(1 - 2 * (int)(offset < 0) );
@@ -323,7 +430,7 @@ bool sc2d_check_poly2d(	float p1x, float p1y, float* p1_verts, int p1_count,
 	*overlap_x *= min_distance;
 	*overlap_y *= min_distance;
 
-	return result;
+	return true;
 }
 
 // Check for collision between point and convex polygon
@@ -1,3 +1,4 @@
+#include "graphics.h"
 #include "platform.h"
 #include "lerp.h"
 #include "math.h"
@@ -16,212 +17,326 @@ float measure_text(STBTTF_Font* font, float size, const char* text) {
 	return result;
 }
 
-void render_text(STBTTF_Font* font, float size, float x, float y, const char* text) {
-	RGBA_Color color = platform_get_render_draw_color();
-	SDL_SetTextureColorMod(font->atlas, color.r, color.g, color.b);
-	SDL_SetTextureAlphaMod(font->atlas, color.a);
+// Text is laid out once per font, string, size and alignment as glyph quads relative to the
+// draw position, then each draw places the quads with one geometry call against the font atlas
+#define TEXT_LAYOUT_CACHE_SIZE 128
+
+typedef struct Text_Layout {
+	STBTTF_Font* font;
+	char* text;
+	float size;
+	float align; // Fraction of the width the text is shifted left by
+	float width;
+
+	SDL_Texture* atlas; // The font's atlas, or in SDF mode the atlas of the page for size
+	SDL_Vertex* vertices; // Four per glyph, untinted
+	int glyph_count;
+} Text_Layout;
+
+static struct {
+	Text_Layout layouts[TEXT_LAYOUT_CACHE_SIZE];
+	int count;
+	int next_replaced; // Once the cache is full, layouts are replaced in turn
+	Render_Batch batch; // A layout placed for drawing
+} text_cache;
+
+static void build_text_layout(Text_Layout* layout, STBTTF_Font* font, float size, const char* text, float align) {
+	*layout = (Text_Layout) {
+		.font = font,
+		.text = SDL_strdup(text),
+		.size = size,
+		.align = align,
+	};
+	layout->vertices = SDL_malloc(sizeof(SDL_Vertex) * 4 * (SDL_strlen(text) + 1));
 
+	stbtt_packedchar* chars = font->chars;
 	float scale = size / font->size;
+	Vector2 texture_size = {(float)font->texture_size, (float)font->texture_size};
+	layout->atlas = font->atlas;
+
+	STBTTF_Font_Page* page = get_stbtt_font_page(font, size);
+	if (page) {
+		chars = page->chars;
+		scale = size / page->size;
+		texture_size = (Vector2){(float)page->texture_w, (float)page->texture_h};
+		layout->atlas = page->atlas;
+	}
 
+	float x = 0;
 	for (int i = 0; text[i]; i++) {
 		if (text[i] >= 32 && text[i] < 128) {
+			stbtt_packedchar* info = &chars[text[i] - 32];
+
+			float x0 = x + info->xoff * scale;
+			float y0 = info->yoff * scale;
+			float x1 = x0 + (info->x1 - info->x0) * scale;
+			float y1 = y0 + (info->y1 - info->y0) * scale;
+			float u0 = info->x0 / texture_size.x, u1 = info->x1 / texture_size.x;
+			float v0 = info->y0 / texture_size.y, v1 = info->y1 / texture_size.y;
+
+			SDL_Vertex* quad = layout->vertices + layout->glyph_count * 4;
+			quad[0] = (SDL_Vertex){ .position = {x0, y0}, .color = {255, 255, 255, 255}, .tex_coord = {u0, v0} };
+			quad[1] = (SDL_Vertex){ .position = {x1, y0}, .color = {255, 255, 255, 255}, .tex_coord = {u1, v0} };
+			quad[2] = (SDL_Vertex){ .position = {x1, y1}, .color = {255, 255, 255, 255}, .tex_coord = {u1, v1} };
+			quad[3] = (SDL_Vertex){ .position = {x0, y1}, .color = {255, 255, 255, 255}, .tex_coord = {u0, v1} };
+			layout->glyph_count++;
 
-			stbtt_packedchar* info = &font->chars[text[i] - 32];
-			Rectangle src_rect = {info->x0, info->y0, info->x1 - info->x0, info->y1 - info->y0};
+			x += info->xadvance * scale;
+		}
+	}
 
-			Rectangle dst_rect = {
-				x + info->xoff * scale, 
-				y + info->yoff * scale, 
-				(info->x1 - info->x0) * scale, 
-				(info->y1 - info->y0) * scale 
-			};
+	layout->width = x;
+	if (align) {
+		for (int i = 0; i < layout->glyph_count * 4; i++) {
+			layout->vertices[i].position.x -= layout->width * align;
+		}
+	}
+}
 
-			platform_render_copy(font->atlas, &src_rect, &dst_rect, 0, 0, 0);
-			x += info->xadvance * scale;
+static Text_Layout* get_text_layout(STBTTF_Font* font, float size, const char* text, float align) {
+	Text_Layout* result = 0;
+	for (int i = 0; i < text_cache.count; i++) {
+		Text_Layout* layout = text_cache.layouts + i;
+		if (	layout->font == font && layout->size == size && layout->align == align
+			&& *layout->text == *text && SDL_strcmp(layout->text, text) == 0
+		) {
+			result = layout;
+			return result;
 		}
 	}
 
+	if (text_cache.count < TEXT_LAYOUT_CACHE_SIZE) {
+		result = text_cache.layouts + text_cache.count++;
+	} else {
+		result = text_cache.layouts + text_cache.next_replaced;
+		text_cache.next_replaced = (text_cache.next_replaced + 1) % TEXT_LAYOUT_CACHE_SIZE;
+		SDL_free(result->text);
+		SDL_free(result->vertices);
+	}
+	build_text_layout(result, font, size, text, align);
+
+	return result;
+}
+
+// Place the layout's glyphs at x,y tinted by the render draw color and draw them in one call
+static void render_text_layout(Text_Layout* layout, float x, float y) {
+	if (layout->glyph_count == 0) return;
+
+	RGBA_Color color = platform_get_render_draw_color();
+	Render_Batch* batch = &text_cache.batch;
+	batch->texture = layout->atlas;
+
+	int first = render_batch_reserve(batch, layout->glyph_count * 4, layout->glyph_count * 6);
+	for (int i = 0; i < layout->glyph_count * 4; i++) {
+		SDL_Vertex vertex = layout->vertices[i];
+		vertex.position.x += x;
+		vertex.position.y += y;
+		vertex.color = (SDL_Color){color.r, color.g, color.b, color.a};
+		batch->vertices[first + i] = vertex;
+	}
+
+	int* indices = batch->indices + batch->index_count;
+	for (int i = 0; i < layout->glyph_count; i++) {
+		int quad = first + i * 4;
+		indices[i*6    ] = quad;
+		indices[i*6 + 1] = quad + 1;
+		indices[i*6 + 2] = quad + 2;
+		indices[i*6 + 3] = quad;
+		indices[i*6 + 4] = quad + 2;
+		indices[i*6 + 5] = quad + 3;
+	}
+	batch->index_count += layout->glyph_count * 6;
+
+	render_batch_submit(batch);
+}
+
+void render_text(STBTTF_Font* font, float size, float x, float y, const char* text) {
+	render_text_layout(get_text_layout(font, size, text, 0), x, y);
 }
 
 void render_text_aligned(STBTTF_Font* font, float size, float x, float y, const char* text, const char* alignment) {
-	float offset_x = x;
-	float offset_y = y;
+	float align = 0;
 
 	if (alignment) {
-		float text_width = measure_text(font, size, text);
 		if (SDL_strcmp(alignment, "center") == 0) {
-			offset_x -= text_width / 2.0f;
+			align = 0.5f;
 		}
 		else if (SDL_strcmp(alignment, "right") == 0) {
-			offset_x -= text_width;	
+			align = 1.0f;
 		}
 	}
 
-	render_text(font, size, offset_x, offset_y, text);
+	render_text_layout(get_text_layout(font, size, text, align), x, y);
 }
 
-void render_draw_circle(int cx, int cy, int r) {
-	if (r <= 0) return;
-	Vector2 points[4];
-	float r_squared = (float)r * (float)r;
+// Circles are drawn from cached meshes, keyed by radius rounded up to CIRCLE_RADIUS_STEP
+// and by their segment and ring counts. Meshes are only built for radii that are actually drawn.
+#define CIRCLE_MESH_CACHE_SIZE 64
+#define CIRCLE_RADIUS_STEP 0.5f
+#define CIRCLE_SEGMENT_LENGTH 3.0f // Rim segments are about this many pixels long
+#define CIRCLE_MIN_SEGMENTS 8
+#define CIRCLE_MAX_SEGMENTS 96
+#define CIRCLE_GRADIENT_RINGS 6 // Gradients are interpolated between rings spaced to follow the falloff
+
+typedef struct Circle_Mesh {
+	int radius_steps;
+	int segments;
+	int rings;
+
+	Vector2* points; // The center, then each ring from the inside out
+	float* t; // Gradient position of each point, 0 at the center and 1 on the rim
+	int* indices;
+	int point_count, index_count;
+} Circle_Mesh;
+
+static struct {
+	Circle_Mesh meshes[CIRCLE_MESH_CACHE_SIZE];
+	int count;
+	int next_replaced; // Once the cache is full, meshes are replaced in turn
+	SDL_Vertex vertices[1 + CIRCLE_MAX_SEGMENTS * CIRCLE_GRADIENT_RINGS]; // A mesh placed for drawing
+} circle_cache;
+
+static void build_circle_mesh(Circle_Mesh* mesh, int radius_steps, int segments, int rings) {
+	float radius = (float)radius_steps * CIRCLE_RADIUS_STEP;
+
+	*mesh = (Circle_Mesh) {
+		.radius_steps = radius_steps,
+		.segments = segments,
+		.rings = rings,
+		.point_count = 1 + segments * rings,
+		.index_count = segments * 3 + segments * 6 * (rings - 1),
+	};
+	mesh->points = SDL_malloc(sizeof(Vector2) * mesh->point_count);
+	mesh->t = SDL_malloc(sizeof(float) * mesh->point_count);
+	mesh->indices = SDL_malloc(sizeof(int) * mesh->index_count);
+
+	mesh->points[0] = (Vector2){0};
+	mesh->t[0] = 0;
+	for (int ring = 1; ring <= rings; ring++) {
+		// Gradient position grows with the square of the distance from the center
+		float t = (float)ring / (float)rings;
+		float ring_radius = radius * SDL_sqrtf(t);
+		int first = 1 + (ring - 1) * segments;
+
+		for (int i = 0; i < segments; i++) {
+			float angle = 360.0f / (float)segments * (float)i;
+			mesh->points[first + i] = (Vector2){cos_deg(angle) * ring_radius, sin_deg(angle) * ring_radius};
+			mesh->t[first + i] = t;
+		}
+	}
 
-	uint8_t* y_used = SDL_malloc(sizeof(uint8_t) * r);
-	uint8_t* x_used = SDL_malloc(sizeof(uint8_t) * r);
-	SDL_memset(y_used, 0, sizeof(uint8_t) * r);
-	SDL_memset(x_used, 0, sizeof(uint8_t) * r);
+	int* indices = mesh->indices;
+	for (int i = 0; i < segments; i++) {
+		int next = (i + 1) % segments;
+		*indices++ = 0;
+		*indices++ = 1 + i;
+		*indices++ = 1 + next;
+	}
 
-	for (int x = 0; x <= r; x++) {
-		int y = (int)SDL_roundf(SDL_sqrtf(r_squared - (float)x*(float)x));
+	for (int ring = 2; ring <= rings; ring++) {
+		int inner = 1 + (ring - 2) * segments;
+		int outer = inner + segments;
 
-		points[0] = (Vector2){cx + x, cy + y};
-		points[1] = (Vector2){cx + x, cy - y};
-		points[2] = (Vector2){cx - x, cy + y};
-		points[3] = (Vector2){cx - x, cy - y};
-	
-		platform_render_draw_points(points, 4);
+		for (int i = 0; i < segments; i++) {
+			int next = (i + 1) % segments;
+			*indices++ = inner + i;
+			*indices++ = outer + i;
+			*indices++ = outer + next;
+
+			*indices++ = inner + i;
+			*indices++ = outer + next;
+			*indices++ = inner + next;
+		}
+	}
+}
 
-		x_used[x] = 1;
-		y_used[y] = 1;
+static Circle_Mesh* get_circle_mesh(float radius, int rings) {
+	int radius_steps = (int)SDL_ceilf(radius / CIRCLE_RADIUS_STEP);
+	float rim_length = 2.0f * (float)MATH_PI * (float)radius_steps * CIRCLE_RADIUS_STEP;
+	int segments = SDL_clamp((int)SDL_ceilf(rim_length / CIRCLE_SEGMENT_LENGTH), CIRCLE_MIN_SEGMENTS, CIRCLE_MAX_SEGMENTS);
+	segments = (segments + 3) & ~3; // Keep the mesh symmetric across both axes
+	rings = SDL_clamp(rings, 1, CIRCLE_GRADIENT_RINGS);
+
+	Circle_Mesh* result = 0;
+	for (int i = 0; i < circle_cache.count; i++) {
+		Circle_Mesh* mesh = circle_cache.meshes + i;
+		if (mesh->radius_steps == radius_steps && mesh->segments == segments && mesh->rings == rings) {
+			result = mesh;
+			return result;
+		}
 	}
 
-	for (int y = 0; y <= r; y++) {
-		if (y_used[y]) continue;
-		int x = (int)SDL_roundf(SDL_sqrtf(r_squared - (float)y*(float)y));
+	if (circle_cache.count < CIRCLE_MESH_CACHE_SIZE) {
+		result = circle_cache.meshes + circle_cache.count++;
+	} else {
+		result = circle_cache.meshes + circle_cache.next_replaced;
+		circle_cache.next_replaced = (circle_cache.next_replaced + 1) % CIRCLE_MESH_CACHE_SIZE;
 
-		points[0] = (Vector2){cx + x, cy + y};
-		points[1] = (Vector2){cx + x, cy - y};
-		points[2] = (Vector2){cx - x, cy + y};
-		points[3] = (Vector2){cx - x, cy - y};
-	
-		platform_render_draw_points(points, 4);
+		SDL_free(result->points);
+		SDL_free(result->t);
+		SDL_free(result->indices);
+	}
+	build_circle_mesh(result, radius_steps, segments, rings);
+
+	return result;
+}
+
+// Fill mesh centered on cx, cy with one geometry call, coloring each point by its gradient position
+static void render_fill_circle_mesh(Circle_Mesh* mesh, float cx, float cy, RGBA_Color start_color, RGBA_Color end_color) {
+	SDL_Vertex* vertices = circle_cache.vertices;
+	for (int i = 0; i < mesh->point_count; i++) {
+		float t = mesh->t[i];
+		vertices[i] = (SDL_Vertex) {
+			.position = {cx + mesh->points[i].x, cy + mesh->points[i].y},
+			.color = {
+				lerp(start_color.r, end_color.r, t),
+				lerp(start_color.g, end_color.g, t),
+				lerp(start_color.b, end_color.b, t),
+				lerp(start_color.a, end_color.a, t),
+			},
+			.tex_coord = {1.0f, 1.0f},
+		};
 	}
 
-	SDL_free(x_used);
-	SDL_free(y_used);
+	platform_render_geometry(NULL, vertices, mesh->point_count, mesh->indices, mesh->index_count);
 }
 
-// TO-DO: Identify crash related to this. This function is bad.
-void render_draw_circlef(float cx, float cy, float r) {
+// Connect the rim of a cached mesh of radius r with lines
+static void render_draw_circle_outline(float cx, float cy, float r) {
 	if (r <= 0) return;
-	Vector2 points[4];
-	float r_squared = r * r;
-	int ri = (int)SDL_ceilf(r);
-	
-	SDL_bool* y_used = SDL_malloc(sizeof(SDL_bool) * ri);
-	SDL_bool* x_used = SDL_malloc(sizeof(SDL_bool) * ri);
-	SDL_memset(y_used, 0, sizeof(SDL_bool) * ri);
-	SDL_memset(x_used, 0, sizeof(SDL_bool) * ri);
-
-	for (int x = 0; x <= ri; x++) {
-		float fx = (float)x;
-		float fy = (x == ri) ? 0 : SDL_sqrtf(r_squared - fx*fx);
-		fy = SDL_clamp(fy, 0, ri);
-
-		points[0] = (Vector2){cx + fx, cy + fy};
-		points[1] = (Vector2){cx + fx, cy - fy};
-		points[2] = (Vector2){cx - fx, cy + fy};
-		points[3] = (Vector2){cx - fx, cy - fy};
-	
-		platform_render_draw_points(points, 4);
+	Circle_Mesh* mesh = get_circle_mesh(r, 1);
+	Vector2 outline[CIRCLE_MAX_SEGMENTS + 1];
 
-		x_used[x] = 1;
-		y_used[(int)fy] = 1;
+	for (int i = 0; i < mesh->segments; i++) {
+		outline[i] = (Vector2){cx + mesh->points[1 + i].x, cy + mesh->points[1 + i].y};
 	}
+	outline[mesh->segments] = outline[0];
 
-	for (int y = 0; y <= ri; y++) {
-		if (y_used[y]) continue;
-		float fy = (float)y;
-		float fx = (y == ri) ? 0 : SDL_sqrtf(r_squared - fy*fy);
-		fy = SDL_clamp(fy, 0, ri);
-		
-		points[0] = (Vector2){cx + fx, cy + fy};
-		points[1] = (Vector2){cx + fx, cy - fy};
-		points[2] = (Vector2){cx - fx, cy + fy};
-		points[3] = (Vector2){cx - fx, cy - fy};
-	
-		platform_render_draw_points(points, 4);
-	}
+	platform_render_draw_lines(outline, mesh->segments + 1);
+}
 
-	SDL_free(x_used);
-	SDL_free(y_used);
+void render_draw_circle(int cx, int cy, int r) {
+	render_draw_circle_outline((float)cx, (float)cy, (float)r);
+}
+
+void render_draw_circlef(float cx, float cy, float r) {
+	render_draw_circle_outline(cx, cy, r);
 }
 
+// Fills cover every pixel within sqrt(r*r + r) of the center, like the point plotting they replaced
 void render_fill_circle(int cx, int cy, int r) {
-	if (r <= 0) return;
-	Vector2 points[4];
-	int radius = (int)r;
-	int r_squared = radius*radius;
-
-	for (int y = 0; y <= radius; y++) {
-		for (int x = 0; x <= radius; x++) {
-			if(x*x + y*y <= r_squared + r) {
-				points[0] = (Vector2){cx + x, cy + y};
-				points[1] = (Vector2){cx + x, cy - y};
-				points[2] = (Vector2){cx - x, cy + y};
-				points[3] = (Vector2){cx - x, cy - y};
-
-				platform_render_draw_points(points, 4);
-			}
-		}
-	}
+	render_fill_circlef((float)cx, (float)cy, (float)r);
 }
 
-// TO-DO: Figure out why sub-pixel rendering doesn't seem to be working here. Very clear pixel jitter on moving objects.
 void render_fill_circlef(float cx, float cy, float r) {
 	if (r <= 0) return;
-	Vector2 points[4];
-	int radius = (int)SDL_roundf(r);
-	float r_squared = r*r;
-
-	for (int y = 0; y <= radius; y++) {
-		for (int x = 0; x <= radius; x++) {
-			float fx = (float)x;
-			float fy = (float)y;
-
-			if(fx*fx + fy*fy <= r_squared + r) {
-				points[0] = (Vector2){cx + fx, cy + fy};
-				points[1] = (Vector2){cx + fx, cy - fy};
-				points[2] = (Vector2){cx - fx, cy + fy};
-				points[3] = (Vector2){cx - fx, cy - fy};
-
-				platform_render_draw_points(points, 4);
-			}
-		}
-	}
+	RGBA_Color color = platform_get_render_draw_color();
+	render_fill_circle_mesh(get_circle_mesh(SDL_sqrtf(r*r + r), 1), cx, cy, color, color);
 }
 
 void render_fill_circlef_linear_gradient(float cx, float cy, float r, RGBA_Color start_color, RGBA_Color end_color) {
 	if (r <= 0) return;
-	Vector2 points[4];
-	int radius = (int)SDL_roundf(r);
-	float r_squared = r*r;
-
-	for (int y = 0; y <= radius; y++) {
-		for (int x = 0; x <= radius; x++) {
-			float fx = (float)x;
-			float fy = (float)y;
-
-			float t = (fx*fx + fy*fy) / (r_squared + r);
-
-			if (t <= 1.0f) {
-				platform_set_render_draw_color( 
-					(RGBA_Color) {
-						lerp(start_color.r, end_color.r, t),
-						lerp(start_color.g, end_color.g, t),
-						lerp(start_color.b, end_color.b, t),
-						lerp(start_color.a, end_color.a, t),
-					}
-				);
-
-				points[0] = (Vector2){cx + fx, cy + fy};
-				points[1] = (Vector2){cx + fx, cy - fy};
-				points[2] = (Vector2){cx - fx, cy + fy};
-				points[3] = (Vector2){cx - fx, cy - fy};
-
-				platform_render_draw_points(points, 4);
-			}
-		}
-	}
+	render_fill_circle_mesh(get_circle_mesh(SDL_sqrtf(r*r + r), CIRCLE_GRADIENT_RINGS), cx, cy, start_color, end_color);
 }
 
 void render_draw_texture(SDL_Texture* texture, float x, float y, float angle, SDL_bool centered) {
@@ -385,3 +500,148 @@ void render_fill_game_shape(Vector2 position, Game_Shape shape, RGBA_Color color
 		} break;
 	}
 }
+
+void render_batch_clear(Render_Batch* batch) {
+	batch->vertex_count = 0;
+	batch->index_count = 0;
+}
+
+// Make room for vertex_count more vertices and index_count more indices. Returns the first new vertex.
+int render_batch_reserve(Render_Batch* batch, int vertex_count, int index_count) {
+	if (batch->vertex_count + vertex_count > batch->vertex_capacity) {
+		batch->vertex_capacity = SDL_max(batch->vertex_count + vertex_count, batch->vertex_capacity * 2);
+		batch->vertices = SDL_realloc(batch->vertices, sizeof(SDL_Vertex) * batch->vertex_capacity);
+	}
+
+	if (batch->index_count + index_count > batch->index_capacity) {
+		batch->index_capacity = SDL_max(batch->index_count + index_count, batch->index_capacity * 2);
+		batch->indices = SDL_realloc(batch->indices, sizeof(int) * batch->index_capacity);
+	}
+
+	int result = batch->vertex_count;
+	batch->vertex_count += vertex_count;
+
+	return result;
+}
+
+static inline void render_batch_push_vertex(Render_Batch* batch, int index, float x, float y, RGBA_Color color) {
+	batch->vertices[index] = (SDL_Vertex) {
+		.position = {x, y},
+		.color = {color.r, color.g, color.b, color.a},
+		.tex_coord = {1.0f, 1.0f},
+	};
+}
+
+// Add src_rect of the batch's texture as a quad of size centered on center and rotated by angle degrees,
+// the same placement as platform_render_copy() with a centered dst_rect
+void render_batch_copy(Render_Batch* batch, Rectangle src_rect, Vector2 texture_size, Vector2 center, Vector2 size, float angle) {
+	if (texture_size.x <= 0 || texture_size.y <= 0) return;
+
+	int first = render_batch_reserve(batch, 4, 6);
+
+	Vector2 corners[4] = {
+		{-size.x/2.0f, -size.y/2.0f},
+		{ size.x/2.0f, -size.y/2.0f},
+		{ size.x/2.0f,  size.y/2.0f},
+		{-size.x/2.0f,  size.y/2.0f},
+	};
+	float u0 = src_rect.x / texture_size.x, u1 = (src_rect.x + src_rect.w) / texture_size.x;
+	float v0 = src_rect.y / texture_size.y, v1 = (src_rect.y + src_rect.h) / texture_size.y;
+	SDL_FPoint tex_coords[4] = { {u0, v0}, {u1, v0}, {u1, v1}, {u0, v1} };
+
+	for (int i = 0; i < 4; i++) {
+		Vector2 corner = rotate_vector2(corners[i], angle);
+		batch->vertices[first + i] = (SDL_Vertex) {
+			.position = {center.x + corner.x, center.y + corner.y},
+			.color = {255, 255, 255, 255},
+			.tex_coord = tex_coords[i],
+		};
+	}
+
+	int* indices = batch->indices + batch->index_count;
+	indices[0] = first;
+	indices[1] = first + 1;
+	indices[2] = first + 2;
+	indices[3] = first;
+	indices[4] = first + 2;
+	indices[5] = first + 3;
+	batch->index_count += 6;
+}
+
+// Triangulate points as a fan around the first point, like render_fill_polygon
+void render_batch_fill_polygon(Render_Batch* batch, Vector2 position, Vector2* points, int num_points, RGBA_Color color) {
+	if (num_points < 3) return;
+
+	int num_triangles = num_points - 2;
+	int first = render_batch_reserve(batch, num_points, num_triangles * 3);
+
+	for (int i = 0; i < num_points; i++) {
+		render_batch_push_vertex(batch, first + i, position.x + points[i].x, position.y + points[i].y, color);
+	}
+
+	int* indices = batch->indices + batch->index_count;
+	for (int triangle = 0; triangle < num_triangles; triangle++) {
+		indices[triangle*3    ] = first;
+		indices[triangle*3 + 1] = first + triangle + 1;
+		indices[triangle*3 + 2] = first + triangle + 2;
+	}
+	batch->index_count += num_triangles * 3;
+}
+
+void render_batch_fill_rect(Render_Batch* batch, Rectangle rect, RGBA_Color color) {
+	Vector2 corners[4] = {
+		{rect.x, rect.y},
+		{rect.x + rect.w, rect.y},
+		{rect.x + rect.w, rect.y + rect.h},
+		{rect.x, rect.y + rect.h},
+	};
+
+	render_batch_fill_polygon(batch, (Vector2){0}, corners, 4, color);
+}
+
+// Circles use the rim and fan of the same cached mesh as render_fill_circlef
+void render_batch_fill_circle(Render_Batch* batch, Vector2 position, float r, RGBA_Color color) {
+	if (r <= 0) return;
+	Circle_Mesh* mesh = get_circle_mesh(r, 1);
+
+	int first = render_batch_reserve(batch, mesh->point_count, mesh->index_count);
+	for (int i = 0; i < mesh->point_count; i++) {
+		render_batch_push_vertex(batch, first + i, position.x + mesh->points[i].x, position.y + mesh->points[i].y, color);
+	}
+
+	int* indices = batch->indices + batch->index_count;
+	for (int i = 0; i < mesh->index_count; i++) {
+		indices[i] = first + mesh->indices[i];
+	}
+	batch->index_count += mesh->index_count;
+}
+
+void render_batch_fill_game_shape(Render_Batch* batch, Vector2 position, Game_Shape shape, RGBA_Color color) {
+	switch(shape.type) {
+		case SHAPE_TYPE_CIRCLE: {
+			render_batch_fill_circle(batch, position, shape.radius, color);
+		} break;
+
+		case SHAPE_TYPE_RECT: {
+			render_batch_fill_rect(batch, translate_rect(shape.rectangle, position), color);
+		} break;
+
+		case SHAPE_TYPE_POLY2D: {
+			render_batch_fill_polygon(batch, position, shape.polygon.vertices, shape.polygon.vert_count, color);
+		} break;
+
+		default: {} break;
+	}
+}
+
+// Draw everything in the batch and clear it
+int render_batch_submit(Render_Batch* batch) {
+	int result = 0;
+
+	if (batch->index_count) {
+		result = platform_render_geometry(batch->texture, batch->vertices, batch->vertex_count, batch->indices, batch->index_count);
+	}
+	render_batch_clear(batch);
+
+	return result;
+}
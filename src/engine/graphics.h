@@ -21,4 +21,25 @@ void 	render_fill_triangle			(Vector2 v1, Vector2 v2, Vector2 v3, RGBA_Color col
 void 	render_draw_game_shape			(Vector2 position, Game_Shape shape, RGBA_Color color);
 void 	render_fill_game_shape			(Vector2 position, Game_Shape shape, RGBA_Color color);
 
+// Triangles collected over a frame and submitted with one platform_render_geometry call.
+// The arrays grow as needed and are kept between frames.
+typedef struct Render_Batch {
+	SDL_Texture* texture; // 0 for untextured geometry
+	Vector2 texture_size; // For the caller to pass to render_batch_copy
+	SDL_Vertex* vertices;
+	int* indices;
+	int vertex_count, vertex_capacity;
+	int index_count, index_capacity;
+} Render_Batch;
+
+void	render_batch_clear			(Render_Batch* batch);
+int	render_batch_reserve			(Render_Batch* batch, int vertex_count, int index_count);
+void	render_batch_fill_polygon		(Render_Batch* batch, Vector2 position, Vector2* points, int num_points, RGBA_Color color);
+void	render_batch_fill_rect			(Render_Batch* batch, Rectangle rect, RGBA_Color color);
+void	render_batch_fill_circle		(Render_Batch* batch, Vector2 position, float r, RGBA_Color color);
+void	render_batch_fill_game_shape		(Render_Batch* batch, Vector2 position, Game_Shape shape, RGBA_Color color);
+void	render_batch_copy			(Render_Batch* batch, Rectangle src_rect, Vector2 texture_size,
+						 Vector2 center, Vector2 size, float angle);
+int	render_batch_submit			(Render_Batch* batch);
+
 #endif
@@ -0,0 +1,139 @@
+#include "jobs.h"
+
+struct Job_Pool {
+	SDL_Thread* threads[JOB_POOL_MAX_WORKERS];
+	int worker_count;
+
+	SDL_mutex* mutex;
+	SDL_cond* job_ready;
+	SDL_cond* job_done;
+	Uint32 generation; // Incremented for every job, so workers never run one twice
+	int workers_busy;
+	SDL_bool quit;
+
+	// The current job
+	Job_Range_Func* func;
+	void* data;
+	Uint32 count, chunk_size, chunk_count;
+	SDL_atomic_t next_chunk;
+};
+
+// Take chunks of the current job until there are none left
+static void run_job_chunks(Job_Pool* pool) {
+	Uint32 chunk;
+	while ( (chunk = (Uint32)SDL_AtomicAdd(&pool->next_chunk, 1)) < pool->chunk_count ) {
+		Uint32 first = chunk * pool->chunk_size;
+		Uint32 last = SDL_min(first + pool->chunk_size, pool->count);
+		pool->func(pool->data, first, last);
+	}
+}
+
+static int job_worker(void* data) {
+	Job_Pool* pool = data;
+	Uint32 generation = 0;
+
+	SDL_LockMutex(pool->mutex);
+	for (;;) {
+		while (!pool->quit && pool->generation == generation) {
+			SDL_CondWait(pool->job_ready, pool->mutex);
+		}
+		if (pool->quit) break;
+
+		generation = pool->generation;
+		SDL_UnlockMutex(pool->mutex);
+
+		run_job_chunks(pool);
+
+		SDL_LockMutex(pool->mutex);
+		pool->workers_busy--;
+		if (pool->workers_busy == 0) {
+			SDL_CondSignal(pool->job_done);
+		}
+	}
+	SDL_UnlockMutex(pool->mutex);
+
+	return 0;
+}
+
+// A pool with no workers runs every job on the calling thread
+Job_Pool* new_job_pool(int worker_count) {
+	if (worker_count == JOB_POOL_AUTO) {
+		worker_count = SDL_GetCPUCount() - 1;
+	}
+	worker_count = SDL_clamp(worker_count, 0, JOB_POOL_MAX_WORKERS);
+
+	Job_Pool* result = SDL_calloc(1, sizeof(Job_Pool));
+	result->mutex = SDL_CreateMutex();
+	result->job_ready = SDL_CreateCond();
+	result->job_done = SDL_CreateCond();
+
+	for (int i = 0; i < worker_count; i++) {
+		SDL_Thread* thread = SDL_CreateThread(job_worker, "Job Worker", result);
+		if (thread == NULL) {
+			SDL_LogError(0, "new_job_pool(): %s", SDL_GetError());
+			break;
+		}
+		result->threads[result->worker_count++] = thread;
+	}
+
+	return result;
+}
+
+void free_job_pool(Job_Pool* pool) {
+	if (pool == NULL) return;
+
+	SDL_LockMutex(pool->mutex);
+	pool->quit = true;
+	SDL_CondBroadcast(pool->job_ready);
+	SDL_UnlockMutex(pool->mutex);
+
+	for (int i = 0; i < pool->worker_count; i++) {
+		SDL_WaitThread(pool->threads[i], 0);
+	}
+
+	SDL_DestroyCond(pool->job_done);
+	SDL_DestroyCond(pool->job_ready);
+	SDL_DestroyMutex(pool->mutex);
+	SDL_free(pool);
+}
+
+int get_job_pool_workers(Job_Pool* pool) {
+	int result = (pool) ? pool->worker_count : 0;
+	return result;
+}
+
+// Call func on [first, last) chunks of [0, count), with the calling thread taking chunks alongside the workers.
+// Returns once every chunk is done. Chunk boundaries only depend on chunk_size,
+// and without a pool or workers the chunks run in order on the calling thread.
+void parallel_for(Job_Pool* pool, Uint32 count, Uint32 chunk_size, Job_Range_Func* func, void* data) {
+	if (count == 0) return;
+	chunk_size = SDL_max(chunk_size, 1);
+	Uint32 chunk_count = (count - 1) / chunk_size + 1;
+
+	if (pool == NULL || pool->worker_count == 0 || chunk_count == 1) {
+		for (Uint32 first = 0; first < count; first += chunk_size) {
+			func(data, first, SDL_min(first + chunk_size, count));
+		}
+		return;
+	}
+
+	SDL_LockMutex(pool->mutex);
+	pool->func = func;
+	pool->data = data;
+	pool->count = count;
+	pool->chunk_size = chunk_size;
+	pool->chunk_count = chunk_count;
+	SDL_AtomicSet(&pool->next_chunk, 0);
+	pool->workers_busy = pool->worker_count;
+	pool->generation++;
+	SDL_CondBroadcast(pool->job_ready);
+	SDL_UnlockMutex(pool->mutex);
+
+	run_job_chunks(pool);
+
+	SDL_LockMutex(pool->mutex);
+	while (pool->workers_busy) {
+		SDL_CondWait(pool->job_done, pool->mutex);
+	}
+	SDL_UnlockMutex(pool->mutex);
+}
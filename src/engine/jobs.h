@@ -0,0 +1,21 @@
+#ifndef JOBS_H
+#define JOBS_H
+
+#include "types.h"
+
+// Fixed pool of worker threads that split loops with the calling thread.
+// Only one thread may submit jobs to a pool.
+typedef struct Job_Pool Job_Pool;
+typedef void Job_Range_Func(void* data, Uint32 first, Uint32 last);
+
+#define JOB_POOL_AUTO -1 // One worker for each CPU core besides the calling thread's
+#define JOB_POOL_MAX_WORKERS 15
+
+Job_Pool*	new_job_pool			(int worker_count);
+void		free_job_pool			(Job_Pool* pool);
+int		get_job_pool_workers		(Job_Pool* pool);
+
+void		parallel_for			(Job_Pool* pool, Uint32 count, Uint32 chunk_size,
+						 Job_Range_Func* func, void* data);
+
+#endif
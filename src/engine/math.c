@@ -37,11 +37,31 @@ float angle_rotation_to_target(Vector2 origin, Vector2 target, float angle, floa
 	return result;
 }
 
-// Returns a pseudo-random value between 0 and 1
-float randomf(void) {
-	float result = (float)(rand() % 1000) / 1000.0f;
+// Series with the same seed and different streams produce unrelated sequences
+void seed_random_series(Random_Series* series, Uint64 seed, Uint64 stream) {
+	series->state = 0;
+	series->increment = (stream << 1u) | 1u;
+	random_u32(series);
+	series->state += seed;
+	random_u32(series);
+}
 
-	return result;
+// Fill values with uniform floats in [0, 1), for loops that need one roll per element
+void fill_random_floats(Random_Series* series, float* values, int count) {
+	for (int i = 0; i < count; i++) {
+		values[i] = random_float(series);
+	}
+}
+
+// FNV-1a, for cheap state checksums
+Uint32 hash_bytes(Uint32 hash, const void* data, size_t size) {
+	const Uint8* bytes = data;
+	for (size_t i = 0; i < size; i++) {
+		hash ^= bytes[i];
+		hash *= 16777619u;
+	}
+
+	return hash;
 }
 
 float vector2_length(Vector2 v) {
@@ -154,6 +174,16 @@ Rectangle center_rect(Rectangle inner, Rectangle outer) {
 	return result;	
 }
 
+float get_poly2d_radius(Poly2D* polygon) {
+	float result = 0;
+	for (int i = 0; i < polygon->vert_count; i++) {
+		Vector2 vertex = polygon->vertices[i];
+		result = SDL_max(result, vertex.x * vertex.x + vertex.y * vertex.y);
+	}
+
+	return SDL_sqrtf(result);
+}
+
 Poly2D rect_to_poly2D(Rectangle rect) {
 	Poly2D result = {
 		.vert_count = 4,
@@ -164,21 +194,23 @@ Poly2D rect_to_poly2D(Rectangle rect) {
 			{rect.x, rect.y + rect.h},
 		},
 	};
+	result.radius = get_poly2d_radius(&result);
 
 	return result;
 }
 
-Poly2D generate_poly2D(int vert_count, float r_min, float r_max) {
+Poly2D generate_poly2D(Random_Series* series, int vert_count, float r_min, float r_max) {
 	Poly2D result = {
 		.vert_count = vert_count,
 	};
 	
 	for (int i = 0; i < vert_count; i++) {
-		float point_dist = r_min + randomf() * (r_max - r_min);
+		float point_dist = r_min + random_float(series) * (r_max - r_min);
 		float new_angle = 360.0f / (float)vert_count * (float)i;
 		
 		result.vertices[i].x = cos_deg(new_angle) * point_dist;
 		result.vertices[i].y = sin_deg(new_angle) * point_dist;
+		result.radius = SDL_max(result.radius, point_dist);
 	}
 
 	return result;
@@ -192,6 +224,7 @@ Poly2D translate_poly2d(Poly2D polygon, Vector2 translation) {
 		result.vertices[i].x = polygon.vertices[i].x + translation.x;
 		result.vertices[i].y = polygon.vertices[i].y + translation.y;
 	}
+	result.radius = get_poly2d_radius(&result);
 
 	return result;
 }
@@ -214,6 +247,7 @@ Poly2D scale_poly2d(Poly2D polygon, Vector2 scale) {
 		result.vertices[i].x = polygon.vertices[i].x * scale.x;
 		result.vertices[i].y = polygon.vertices[i].y * scale.y;
 	}
+	result.radius = polygon.radius * SDL_max(SDL_fabsf(scale.x), SDL_fabsf(scale.y));
 
 	return result;
 }
@@ -303,67 +337,204 @@ Game_Shape rotate_game_shape(Game_Shape shape, float degrees) {
 	return result;
 }
 
-SDL_bool check_shape_collision(Transform2D t1, Game_Shape s1, Transform2D t2, Game_Shape s2, Vector2* overlap) {
-	SDL_bool result = false;
+Collider get_collider(Transform2D transform, Game_Shape shape) {
+	Collider result = {
+		.type = SHAPE_TYPE_UNDEFINED,
+		.position = transform.position,
+	};
+	Poly2D polygon = {0};
+
+	switch(shape.type) {
+		case SHAPE_TYPE_POLY2D: {
+			if (shape.polygon.vert_count == 0) return result;
+			polygon = shape.polygon;
+		} break;
+
+		case SHAPE_TYPE_RECT: {
+			if (shape.rectangle.w == 0 || shape.rectangle.h == 0) return result;
+			polygon = rect_to_poly2D(shape.rectangle);
+		} break;
+
+		case SHAPE_TYPE_CIRCLE: {
+			if (shape.radius == 0) return result;
+
+			// Circles only stay circular under uniform scale
+			float sx = SDL_fabsf(transform.sx);
+			if (sx == SDL_fabsf(transform.sy)) {
+				float radius = shape.radius * sx;
+				if (radius == 0) return result;
+
+				result.type = SHAPE_TYPE_CIRCLE;
+				result.radius = radius;
+				result.bounds = (Rectangle){-radius, -radius, radius * 2.0f, radius * 2.0f};
+				return result;
+			}
+
+			float angle = 0;
+			float angle_increment = 360.0f / (float)MAX_POLY2D_VERTS;
+			for (int circle_vert = 0; circle_vert < MAX_POLY2D_VERTS; circle_vert++) {
+				polygon.vertices[circle_vert].x = cos_deg(angle) * shape.radius;
+				polygon.vertices[circle_vert].y = sin_deg(angle) * shape.radius;
+
+				angle += angle_increment;
+			}
+			polygon.vert_count = MAX_POLY2D_VERTS;
+			polygon.radius = shape.radius;
+		} break;
+
+		default: return result;
+	}
+	
+	if (transform.sx != 1.0f || transform.sy != 1.0f) {
+		polygon = scale_poly2d(polygon, transform.scale);
+	}
+	if (transform.angle != 0) {
+		polygon = rotate_poly2d(polygon, transform.angle);
+	}
 
-	Transform2D* transforms[2] = {&t1, &t2};
-	Game_Shape* shapes[2] = {&s1, &s2};
-	Poly2D colliders[2];
+	// Unrotated rects stay axis-aligned, so they can skip SAT against each other
+	result.type = (shape.type == SHAPE_TYPE_RECT && transform.angle == 0) ? SHAPE_TYPE_RECT : SHAPE_TYPE_POLY2D;
+	result.polygon = polygon;
+	result.radius = (polygon.radius) ? polygon.radius : get_poly2d_radius(&polygon);
 
-	for (int i = 0; i < 2; i++) {
-		switch(shapes[i]->type) {
-			case SHAPE_TYPE_POLY2D: {
-				colliders[i] = shapes[i]->polygon;
-			} break;
+	Vector2 min = polygon.vertices[0];
+	Vector2 max = polygon.vertices[0];
+	for (int i = 0; i < polygon.vert_count; i++) {
+		Vector2 vertex = polygon.vertices[i];
+		Vector2 edge = subtract_vector2(polygon.vertices[(i+1) % polygon.vert_count], vertex);
+		float length = SDL_sqrtf(edge.x * edge.x + edge.y * edge.y);
 
-			case SHAPE_TYPE_RECT: {
-				if (shapes[i]->rectangle.w == 0 || shapes[i]->rectangle.h == 0) return result;
-
-				colliders[i].vertices[0] = (Vector2) {
-					shapes[i]->rectangle.x,
-					shapes[i]->rectangle.y,
-				};
-				colliders[i].vertices[1] = (Vector2) {
-					shapes[i]->rectangle.x + shapes[i]->rectangle.w,
-					shapes[i]->rectangle.y,
-				};
-				colliders[i].vertices[2] = (Vector2) {
-					shapes[i]->rectangle.x + shapes[i]->rectangle.w,
-					shapes[i]->rectangle.y + shapes[i]->rectangle.h,
-				};
-				colliders[i].vertices[3] = (Vector2) {
-					shapes[i]->rectangle.x,
-					shapes[i]->rectangle.y + shapes[i]->rectangle.h,
-				};
-				colliders[i].vert_count = 4;
-			} break;
+		// Same axis sc2d_check_poly2d derives from each edge
+		result.normals[i] = (Vector2){-edge.y / length, edge.x / length};
 
-			case SHAPE_TYPE_CIRCLE: {
-				if (shapes[i]->radius == 0) return result;
+		min.x = SDL_min(min.x, vertex.x);
+		min.y = SDL_min(min.y, vertex.y);
+		max.x = SDL_max(max.x, vertex.x);
+		max.y = SDL_max(max.y, vertex.y);
+	}
+	result.bounds = (Rectangle){min.x, min.y, max.x - min.x, max.y - min.y};
 
-				float angle = 0;
-				float angle_increment = 360.0f / (float)MAX_POLY2D_VERTS;
-				for (int circle_vert = 0; circle_vert < MAX_POLY2D_VERTS; circle_vert++) {
-					colliders[i].vertices[circle_vert].x = cos_deg(angle) * shapes[i]->radius;
-					colliders[i].vertices[circle_vert].y = sin_deg(angle) * shapes[i]->radius;
+	return result;
+}
 
-					angle += angle_increment;
-				}
-				colliders[i].vert_count = MAX_POLY2D_VERTS;
-			} break;
+static SDL_bool check_poly_poly(Collider* c1, Collider* c2, Vector2* overlap) {
+	return sc2d_check_poly2d_normals(
+		c1->position.x, c1->position.y, (float*)c1->polygon.vertices, (float*)c1->normals, c1->polygon.vert_count,
+		c2->position.x, c2->position.y, (float*)c2->polygon.vertices, (float*)c2->normals, c2->polygon.vert_count,
+		&overlap->x, &overlap->y
+	);
+}
 
-			default: break;
-		}
-		
-		colliders[i] = scale_poly2d(colliders[i], transforms[i]->scale);
-		colliders[i] = rotate_poly2d(colliders[i], transforms[i]->angle);
+static SDL_bool check_circle_circle(Collider* c1, Collider* c2, Vector2* overlap) {
+	// sc2d_check_circles has no direction to push concentric circles
+	if (c1->position.x == c2->position.x && c1->position.y == c2->position.y) {
+		*overlap = (Vector2){c1->radius + c2->radius, 0};
+		return true;
 	}
 
-	result = sc2d_check_poly2d(
-		t1.x, t1.y, (float*)colliders[0].vertices, colliders[0].vert_count,
-		t2.x, t2.y, (float*)colliders[1].vertices, colliders[1].vert_count,
+	return sc2d_check_circles(
+		c1->position.x, c1->position.y, c1->radius, 
+		c2->position.x, c2->position.y, c2->radius, 
+		&overlap->x, &overlap->y
+	);
+}
+
+static SDL_bool check_circle_poly(Collider* c1, Collider* c2, Vector2* overlap) {
+	return sc2d_check_circle_poly2d(
+		c1->position.x, c1->position.y, c1->radius,
+		c2->position.x, c2->position.y, (float*)c2->polygon.vertices, (float*)c2->normals, c2->polygon.vert_count,
 		&overlap->x, &overlap->y
 	);
+}
+
+static SDL_bool check_poly_circle(Collider* c1, Collider* c2, Vector2* overlap) {
+	SDL_bool result = check_circle_poly(c2, c1, overlap);
+	if (result) {
+		overlap->x = -overlap->x;
+		overlap->y = -overlap->y;
+	}
+
+	return result;
+}
+
+// Same result as the separating axis test on the two axes. sc2d_check_rects pushes a rect past the
+// far edge of one it's nested in, so deep overlaps would push further than the polygon path did.
+static SDL_bool check_rect_rect(Collider* c1, Collider* c2, Vector2* overlap) {
+	Rectangle r1 = translate_rect(c1->bounds, c1->position);
+	Rectangle r2 = translate_rect(c2->bounds, c2->position);
+	float overlap_x = SDL_min(r1.x + r1.w, r2.x + r2.w) - SDL_max(r1.x, r2.x);
+	float overlap_y = SDL_min(r1.y + r1.h, r2.y + r2.h) - SDL_max(r1.y, r2.y);
+	if (overlap_x <= 0 || overlap_y <= 0) return false;
+
+	if (overlap_y <= overlap_x) {
+		*overlap = (Vector2){0, (c2->position.y < c1->position.y) ? -overlap_y : overlap_y};
+	} else {
+		*overlap = (Vector2){(c2->position.x < c1->position.x) ? -overlap_x : overlap_x, 0};
+	}
+
+	return true;
+}
+
+typedef SDL_bool (*Collider_Collision_Func)(Collider* c1, Collider* c2, Vector2* overlap);
+
+static const Collider_Collision_Func collider_collision_table[SHAPE_TYPE_COUNT][SHAPE_TYPE_COUNT] = {
+	[SHAPE_TYPE_CIRCLE] = {
+		[SHAPE_TYPE_CIRCLE]	= check_circle_circle,
+		[SHAPE_TYPE_RECT]	= check_circle_poly,
+		[SHAPE_TYPE_POLY2D]	= check_circle_poly,
+	},
+	[SHAPE_TYPE_RECT] = {
+		[SHAPE_TYPE_CIRCLE]	= check_poly_circle,
+		[SHAPE_TYPE_RECT]	= check_rect_rect,
+		[SHAPE_TYPE_POLY2D]	= check_poly_poly,
+	},
+	[SHAPE_TYPE_POLY2D] = {
+		[SHAPE_TYPE_CIRCLE]	= check_poly_circle,
+		[SHAPE_TYPE_RECT]	= check_poly_poly,
+		[SHAPE_TYPE_POLY2D]	= check_poly_poly,
+	},
+};
+
+static Collision_Stats collision_stats;
+
+Collision_Stats get_collision_stats(void) {
+	return collision_stats;
+}
+
+void reset_collision_stats(void) {
+	collision_stats = (Collision_Stats){0};
+}
+
+// Overlap points from the first collider toward the second
+SDL_bool check_collider_collision(Collider* c1, Collider* c2, Vector2* overlap) {
+	SDL_bool result = false;
+
+	if (	c1->type > SHAPE_TYPE_UNDEFINED && c1->type < SHAPE_TYPE_COUNT 
+		&& c2->type > SHAPE_TYPE_UNDEFINED && c2->type < SHAPE_TYPE_COUNT
+	) {
+		collision_stats.pairs_tested++;
+
+		// Colliders whose bounding circles don't touch can't overlap
+		float delta_x = c2->position.x - c1->position.x;
+		float delta_y = c2->position.y - c1->position.y;
+		float reach = c1->radius + c2->radius;
+		if (delta_x * delta_x + delta_y * delta_y > reach * reach) {
+			collision_stats.pairs_rejected++;
+			return result;
+		}
+
+		if (c1->type != c2->type || c1->type == SHAPE_TYPE_POLY2D) {
+			collision_stats.pairs_sat++;
+		}
+		result = collider_collision_table[c1->type][c2->type](c1, c2, overlap);
+	}
 
 	return result;
 }
+
+SDL_bool check_shape_collision(Transform2D t1, Game_Shape s1, Transform2D t2, Game_Shape s2, Vector2* overlap) {
+	Collider c1 = get_collider(t1, s1);
+	Collider c2 = get_collider(t2, s2);
+
+	return check_collider_collision(&c1, &c2, overlap);
+}
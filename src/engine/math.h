@@ -31,7 +31,8 @@ Rectangle fit_rect		(Rectangle inner, Rectangle outer);
 Rectangle center_rect		(Rectangle inner, Rectangle outer);
 Poly2D rect_to_poly2D		(Rectangle rect);
 
-Poly2D generate_poly2D		(int vert_count, float r_min, float r_max);
+float get_poly2d_radius		(Poly2D* polygon);
+Poly2D generate_poly2D		(Random_Series* series, int vert_count, float r_min, float r_max);
 Poly2D translate_poly2d		(Poly2D polygon, Vector2 translation);
 Poly2D rotate_poly2d		(Poly2D p, float degrees);
 Poly2D scale_poly2d		(Poly2D polygon, Vector2 scale);
@@ -39,7 +40,38 @@ Poly2D scale_poly2d		(Poly2D polygon, Vector2 scale);
 Game_Shape scale_game_shape	(Game_Shape shape, Vector2 scale);
 Game_Shape rotate_game_shape	(Game_Shape shape, float degrees);
 SDL_bool check_shape_collision	(Transform2D, Game_Shape s1, Transform2D t2, Game_Shape s2, Vector2* overlap);
+Collider get_collider		(Transform2D transform, Game_Shape shape);
+SDL_bool check_collider_collision(Collider* c1, Collider* c2, Vector2* overlap);
 
-float randomf			(void);
+// Pair counts from check_collider_collision since the last reset
+typedef struct Collision_Stats {
+	Uint32 pairs_tested;
+	Uint32 pairs_rejected; // Bounding circles apart, rejected before the narrowphase
+	Uint32 pairs_sat; // Sent to a separating axis test
+} Collision_Stats;
+
+Collision_Stats get_collision_stats	(void);
+void reset_collision_stats		(void);
+
+void seed_random_series		(Random_Series* series, Uint64 seed, Uint64 stream);
+void fill_random_floats		(Random_Series* series, float* values, int count);
+
+// PCG32 (XSH RR). Series seeded with the same seed but different streams are independent.
+static inline Uint32 random_u32(Random_Series* series) {
+	Uint64 state = series->state;
+	series->state = state * 6364136223846793005ull + series->increment;
+
+	Uint32 xorshifted = (Uint32)(((state >> 18u) ^ state) >> 27u);
+	Uint32 rotation = (Uint32)(state >> 59u);
+	return (xorshifted >> rotation) | (xorshifted << ((-rotation) & 31));
+}
+
+// Uniform in [0, 1)
+static inline float random_float(Random_Series* series) {
+	return (float)(random_u32(series) >> 8) * (1.0f / 16777216.0f);
+}
+
+#define HASH_BYTES_SEED 2166136261u
+Uint32 hash_bytes		(Uint32 hash, const void* data, size_t size);
 
 #endif
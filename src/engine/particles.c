@@ -1,8 +1,16 @@
 #include "assets.h"
 #include "graphics.h"
+#include "jobs.h"
 #include "math.h"
+#include "particles.h"
+#include "spatial_grid.h"
 #include "types.h"
 
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define PARTICLES_SSE 1
+#endif
+
 #define PARTICLE_LIFETIME 12
 #define PARTICLE_MIN_SCALE 0.01
 #define PARTICLE_MAX_START_RADIUS 7
@@ -11,27 +19,213 @@
 #define PARTICLE_DECAY 0.75f
 #define EXPLOSION_STARTING_PARTICLES 12
 #define DEFAULT_PARTICLE_COLOR (RGBA_Color){255, 255, 255, 255}
-#define DEAD_PARTICLE_MAX 16
 
-#define MAX_PARTICLES 512
-#define MAX_PARTICLE_EMITTERS 128
+#define PARTICLE_RANDOM_STREAM 1
+
+// Emitter density and explosion sizes are scaled by the budget governor
+#define PARTICLE_BUDGET_MIN_SCALE 0.25f
+#define PARTICLE_BUDGET_DECREASE 0.9f // Multiplied into the scale every frame over budget
+#define PARTICLE_BUDGET_INCREASE 0.01f // Added to the scale every frame with headroom
+#define PARTICLE_BUDGET_HEADROOM 0.75f // Fraction of the budget the frame time has to drop under to recover
+#define PARTICLE_FRAME_TIME_SMOOTHING 0.1f
+
+#define PARTICLE_GRID_CELL_SIZE 64.0f
+#define PARTICLE_GRID_PADDING 1.0f
+
+// Updates are split into chunks of a fixed size, each with its own random series,
+// so results are the same whichever thread runs a chunk
+#define PARTICLE_JOB_CHUNK 2048
+#define EMITTER_JOB_CHUNK 128
+
+#define PARTICLE_SPRITE_BATCHES 16 // Distinct textures batched per frame before batches are reused
+
+// Shapes and directions are generated with the system, so spawning particles only picks indices.
+// Shape template 0 is the unrandomized shape given by init_particle.
+#define PARTICLE_SHAPE_TEMPLATES 256
+#define PARTICLE_DIRECTIONS 256
+
+typedef struct Particle_Shape_Template {
+	float radius; // Circle radius, and half the width of rects
+	Poly2D polygon;
+} Particle_Shape_Template;
+
+// A particle spawned by an emitter, waiting to be added to the system
+typedef struct Staged_Particle {
+	Particle particle;
+	Vector2 position;
+	Vector2 velocity;
+} Staged_Particle;
+
+// Emitter handles pack the emitter index with the generation of its slot
+#define EMITTER_INDEX_BITS 16
+#define EMITTER_INDEX_MASK ((1u << EMITTER_INDEX_BITS) - 1)
 
 struct Particle_System {
-	Particle particles[MAX_PARTICLES];
+	// Hot lanes, streamed every tick by update_particles
+	float* x;
+	float* y;
+	float* vx;
+	float* vy;
+	float* timers;
+	float* decay_rolls; // Scratch, refilled every tick
+
+	Particle* particles;
+	Collider* colliders; // Built by update_particle_colliders, moved by displace_particles
 	Uint32 particle_count;
+	Uint32 capacity;
 
-	Particle_Emitter emitters[MAX_PARTICLE_EMITTERS];
-	Uint32 dead_emitters[MAX_PARTICLE_EMITTERS];
+	// Particles binned by collider, rebuilt once per tick so displace_particles only visits nearby cells
+	Spatial_Grid* grid;
+	Uint32* candidates;
+
+	Particle_Emitter* emitters;
+	Uint32* dead_emitters;
+	Uint16* emitter_generations;
 	Uint32 emitter_count;
 	Uint32 dead_emitter_count;
+	Uint32 emitter_capacity;
+
+	// Emitters stage their particles in parallel, each in the slots from its spawn offset to the next emitter's
+	Uint32* emitter_spawn_offsets;
+	Staged_Particle* staged;
+	Uint32 staged_capacity;
+
+	Job_Pool* jobs; // Null updates on the calling thread
+
+	Render_Batch shape_batch; // Every non-sprite particle, drawn with one call
+	Render_Batch sprite_batches[PARTICLE_SPRITE_BATCHES]; // One per texture
+
+	Particle_Shape_Template shape_templates[PARTICLE_SHAPE_TEMPLATES];
+	Vector2 directions[PARTICLE_DIRECTIONS]; // Unit vectors, evenly spaced around the circle
+
+	float budget_scale;
+	float frame_time; // Smoothed milliseconds, as reported to govern_particle_budget
+
+	Particle_Stats stats; // This frame's
+	Particle_Stats last_stats; // The last ended frame's
+	Random_Series random;
+	SDL_bool stable_order; // Keep draw order when removing expired particles
 };
 
-Particle_System* new_particle_system(void) {
+static float random_particle_radius(Random_Series* series);
+
+static void generate_particle_templates(Particle_System* ps) {
+	Random_Series* series = &ps->random;
+
+	Particle_Shape_Template* template = ps->shape_templates;
+	template->radius = PARTICLE_MAX_START_RADIUS;
+	template->polygon = generate_poly2D(series, 5, PARTICLE_MAX_START_RADIUS, PARTICLE_MAX_START_RADIUS/2);
+
+	for (int t = 1; t < PARTICLE_SHAPE_TEMPLATES; t++) {
+		template = ps->shape_templates + t;
+		template->radius = random_particle_radius(series);
+
+		int vert_count = SDL_clamp(3 + (random_float(series) * 5.0f), 3, MAX_POLY2D_VERTS);
+		float angle_increment = 360.0f / (float)vert_count;
+
+		float angle = 0;
+		float radius = template->radius;
+		for (int v = 0; v < vert_count; v++) {
+			template->polygon.vertices[v] = (Vector2) {
+				cos_deg(angle) * radius,
+				sin_deg(angle) * radius,
+			};
+
+			angle += angle_increment;
+			radius = random_particle_radius(series);
+		}
+		template->polygon.vert_count = vert_count;
+	}
+
+	for (int d = 0; d < PARTICLE_DIRECTIONS; d++) {
+		float angle = (float)d * (360.0f / (float)PARTICLE_DIRECTIONS);
+		ps->directions[d] = (Vector2){cos_deg(angle), sin_deg(angle)};
+	}
+}
+
+// Both capacities include the reserved id 0
+Particle_System* new_particle_system(Uint32 capacity, Uint32 emitter_capacity, Uint64 seed) {
 	Particle_System* result = SDL_calloc(1, sizeof(Particle_System));
+	capacity = SDL_max(capacity, 2);
+	emitter_capacity = SDL_clamp(emitter_capacity, 2, EMITTER_INDEX_MASK);
+
+	result->x		= SDL_calloc(capacity, sizeof(float));
+	result->y		= SDL_calloc(capacity, sizeof(float));
+	result->vx		= SDL_calloc(capacity, sizeof(float));
+	result->vy		= SDL_calloc(capacity, sizeof(float));
+	result->timers		= SDL_calloc(capacity, sizeof(float));
+	result->decay_rolls	= SDL_calloc(capacity, sizeof(float));
+	result->particles	= SDL_calloc(capacity, sizeof(Particle));
+	result->colliders	= SDL_calloc(capacity, sizeof(Collider));
+	result->candidates	= SDL_calloc(capacity, sizeof(Uint32));
+	result->grid = new_spatial_grid(PARTICLE_GRID_CELL_SIZE);
+	result->capacity = capacity;
+
+	result->emitters		= SDL_calloc(emitter_capacity, sizeof(Particle_Emitter));
+	result->dead_emitters		= SDL_calloc(emitter_capacity, sizeof(Uint32));
+	result->emitter_generations	= SDL_calloc(emitter_capacity, sizeof(Uint16));
+	result->emitter_spawn_offsets	= SDL_calloc(emitter_capacity + 1, sizeof(Uint32));
+	result->emitter_capacity = emitter_capacity;
 	result->emitter_count = 1;
+	result->budget_scale = 1.0f;
+
+	seed_random_series(&result->random, seed, PARTICLE_RANDOM_STREAM);
+	generate_particle_templates(result);
 	return result;
 }
 
+// Split updates across pool's workers. Results are the same with any worker count.
+void set_particle_job_pool(Particle_System* ps, Job_Pool* pool) {
+	ps->jobs = pool;
+}
+
+// Counts for the last frame passed to end_particle_stats_frame
+Particle_Stats get_particle_stats(Particle_System* ps) {
+	return ps->last_stats;
+}
+
+// Call once per frame, so each frame's counts can be seen instead of a running total
+void end_particle_stats_frame(Particle_System* ps) {
+	ps->last_stats = ps->stats;
+	ps->stats = (Particle_Stats){0};
+}
+
+// Report how long the last frame took to simulate and render. While the smoothed time
+// is over budget_ms, fewer particles are emitted and exploded, until there's headroom again.
+void govern_particle_budget(Particle_System* ps, float frame_ms, float budget_ms) {
+	if (budget_ms <= 0) return;
+
+	if (ps->frame_time == 0) ps->frame_time = frame_ms;
+	ps->frame_time += (frame_ms - ps->frame_time) * PARTICLE_FRAME_TIME_SMOOTHING;
+
+	if (ps->frame_time > budget_ms) {
+		ps->budget_scale = SDL_max(ps->budget_scale * PARTICLE_BUDGET_DECREASE, PARTICLE_BUDGET_MIN_SCALE);
+	} else if (ps->frame_time < budget_ms * PARTICLE_BUDGET_HEADROOM) {
+		ps->budget_scale = SDL_min(ps->budget_scale + PARTICLE_BUDGET_INCREASE, 1.0f);
+	}
+}
+
+float get_particle_budget_scale(Particle_System* ps) {
+	return ps->budget_scale;
+}
+
+Uint32 get_particle_count(Particle_System* ps) {
+	return ps->particle_count;
+}
+
+Uint32 hash_particle_system(Particle_System* ps, Uint32 hash) {
+	for (int i = 0; i < ps->particle_count; i++) {
+		hash = hash_bytes(hash, ps->x + i, sizeof(float));
+		hash = hash_bytes(hash, ps->y + i, sizeof(float));
+		hash = hash_bytes(hash, ps->vx + i, sizeof(float));
+		hash = hash_bytes(hash, ps->vy + i, sizeof(float));
+		hash = hash_bytes(hash, ps->timers + i, sizeof(float));
+	}
+	hash = hash_bytes(hash, &ps->random.state, sizeof(ps->random.state));
+
+	return hash;
+}
+
 void reset_particle_system(Particle_System* ps) {
 	ps->particle_count = 0;
 	ps->dead_emitter_count = 0;
@@ -40,80 +234,272 @@ void reset_particle_system(Particle_System* ps) {
 
 static void update_particle_emitters(Particle_System* ps, float dt);
 
-void update_particles(Particle_System* ps, float dt) {
-	update_particle_emitters(ps, dt);	
+// Build the particle's shape from its template. Rects have their origin at 0,0.
+static inline Game_Shape get_particle_shape(Particle_System* ps, Uint32 p, Vector2 scale) {
+	Particle* particle = ps->particles + p;
+	Particle_Shape_Template* template = ps->shape_templates + particle->shape_template;
 
-	Uint32 dead_particles[DEAD_PARTICLE_MAX];
-	Uint32 dead_particle_count = 0;
-	for (int p = 0; p < ps->particle_count; p++) {
-		Particle* particle = ps->particles + p;
-		
-		if (randomf() * 100 > 50) {
-			particle->timer -= PARTICLE_DECAY * dt;
-		}
-		
-		if (particle->timer <= 0 && dead_particle_count < array_length(dead_particles)) {
-			dead_particles[dead_particle_count] = p;
-			dead_particle_count++;
+	Game_Shape result = { .type = particle->shape_type };
+	switch(result.type) {
+		case SHAPE_TYPE_CIRCLE: {
+			result.radius = template->radius;
+		} break;
+
+		case SHAPE_TYPE_RECT: {
+			result.rectangle = (Rectangle){0, 0, template->radius*2.0f, template->radius*2.0f};
+		} break;
+
+		case SHAPE_TYPE_POLY2D: {
+			result.polygon = template->polygon;
+		} break;
+		default: { break; }
+	}
+
+	scale.x *= particle->scale.x;
+	scale.y *= particle->scale.y;
+	result = scale_game_shape(result, scale);
+
+	return result;
+}
+
+// Particles shrink as their timer runs out
+static inline Transform2D get_particle_transform(Particle_System* ps, Uint32 p) {
+	float scale = SDL_clamp(ps->timers[p] / (float)PARTICLE_LIFETIME, 0.0f, 1.0f);
+	Transform2D result = {
+		.position = {ps->x[p], ps->y[p]},
+		.scale = {scale, scale},
+		.angle = ps->particles[p].angle,
+	};
+
+	return result;
+}
+
+static inline void move_particle(Particle_System* ps, Uint32 from, Uint32 to) {
+	ps->x[to] = ps->x[from];
+	ps->y[to] = ps->y[from];
+	ps->vx[to] = ps->vx[from];
+	ps->vy[to] = ps->vy[from];
+	ps->timers[to] = ps->timers[from];
+	ps->particles[to] = ps->particles[from];
+}
+
+// Decay, integrate and wrap particles [first, last) one at a time
+static void update_particle_range(Particle_System* ps, float* decay_rolls, Uint32 first, Uint32 last, float dt, Rectangle bounds) {
+	float decay = PARTICLE_DECAY * dt;
+	for (Uint32 p = first; p < last; p++) {
+		if (decay_rolls[p] > 0.5f) {
+			ps->timers[p] -= decay;
 		}
 
-		particle->x += particle->vx * dt;
-		particle->y += particle->vy * dt;
+		Vector2 position = wrap_coords(
+			ps->x[p] + ps->vx[p] * dt, ps->y[p] + ps->vy[p] * dt,
+			bounds.x, bounds.y, bounds.x+bounds.w, bounds.y+bounds.h
+		);
+		ps->x[p] = position.x;
+		ps->y[p] = position.y;
 	}
-	
-	for (Uint32 d = 0; d < dead_particle_count; d++) {
-		if (dead_particles[d] != ps->particle_count-1) {
-			*(ps->particles + dead_particles[d]) = *(ps->particles + (ps->particle_count-1));
+}
+
+#if PARTICLES_SSE
+// Same as wrap_coords() on one axis for 4 lanes
+static inline __m128 wrap_lanes(__m128 v, __m128 min, __m128 max) {
+	__m128 below = _mm_cmplt_ps(v, min);
+	__m128 above = _mm_andnot_ps(below, _mm_cmpgt_ps(v, max));
+	__m128 inside = _mm_andnot_ps(_mm_or_ps(below, above), v);
+
+	return _mm_or_ps(inside, _mm_or_ps(
+		_mm_and_ps(below, _mm_add_ps(max, v)),
+		_mm_and_ps(above, _mm_sub_ps(v, max))
+	));
+}
+
+// Gives the same results as update_particle_range, 4 particles at a time. Returns the first particle left over.
+static Uint32 update_particle_lanes(Particle_System* ps, float* decay_rolls, Uint32 first, Uint32 last, float dt, Rectangle bounds) {
+	__m128 dt4 = _mm_set1_ps(dt);
+	__m128 decay = _mm_set1_ps(PARTICLE_DECAY * dt);
+	__m128 half = _mm_set1_ps(0.5f);
+	__m128 min_x = _mm_set1_ps(bounds.x), max_x = _mm_set1_ps(bounds.x+bounds.w);
+	__m128 min_y = _mm_set1_ps(bounds.y), max_y = _mm_set1_ps(bounds.y+bounds.h);
+
+	Uint32 p = first;
+	for (; p + 4 <= last; p += 4) {
+		__m128 decaying = _mm_cmpgt_ps(_mm_loadu_ps(decay_rolls + p), half);
+		_mm_storeu_ps(ps->timers + p, _mm_sub_ps(_mm_loadu_ps(ps->timers + p), _mm_and_ps(decaying, decay)));
+
+		__m128 x = _mm_add_ps(_mm_loadu_ps(ps->x + p), _mm_mul_ps(_mm_loadu_ps(ps->vx + p), dt4));
+		__m128 y = _mm_add_ps(_mm_loadu_ps(ps->y + p), _mm_mul_ps(_mm_loadu_ps(ps->vy + p), dt4));
+		_mm_storeu_ps(ps->x + p, wrap_lanes(x, min_x, max_x));
+		_mm_storeu_ps(ps->y + p, wrap_lanes(y, min_y, max_y));
+	}
+
+	return p;
+}
+#endif
+
+// Remove every particle whose timer has run out
+static void remove_expired_particles(Particle_System* ps) {
+	if (ps->stable_order) {
+		// Slide live particles down over the expired ones
+		Uint32 live_count = 0;
+		for (Uint32 p = 0; p < ps->particle_count; p++) {
+			if (ps->timers[p] > 0) {
+				if (p != live_count) {
+					move_particle(ps, p, live_count);
+				}
+				live_count++;
+			}
+		}
+		ps->particle_count = live_count;
+	} else {
+		// Fill each hole with the last particle, which is checked again before moving on
+		Uint32 p = 0;
+		while (p < ps->particle_count) {
+			if (ps->timers[p] <= 0) {
+				ps->particle_count--;
+				if (p != ps->particle_count) {
+					move_particle(ps, ps->particle_count, p);
+				}
+			} else {
+				p++;
+			}
 		}
-		ps->particle_count--;
 	}
 }
 
-void wrap_particles(Particle_System* ps, Rectangle bounds) {
-	for (Particle* p = ps->particles; p != ps->particles+ps->particle_count; p++) {
-		p->position = wrap_coords(p->x, p->y, bounds.x, bounds.y, bounds.x+bounds.w, bounds.y+bounds.h);
+void set_particle_stable_order(Particle_System* ps, SDL_bool stable) {
+	ps->stable_order = stable;
+}
+
+typedef struct Particle_Update_Job {
+	Particle_System* ps;
+	float dt;
+	Rectangle bounds;
+	Uint64 seed;
+} Particle_Update_Job;
+
+static void update_particle_chunk(void* data, Uint32 first, Uint32 last) {
+	Particle_Update_Job* job = data;
+	Particle_System* ps = job->ps;
+
+	Random_Series series;
+	seed_random_series(&series, job->seed, first / PARTICLE_JOB_CHUNK);
+	fill_random_floats(&series, ps->decay_rolls + first, last - first);
+
+	Uint32 first_scalar = first;
+#if PARTICLES_SSE
+	first_scalar = update_particle_lanes(ps, ps->decay_rolls, first, last, job->dt, job->bounds);
+#endif
+	update_particle_range(ps, ps->decay_rolls, first_scalar, last, job->dt, job->bounds);
+}
+
+// Decay, move and wrap every particle into bounds in one pass, then remove expired particles
+void update_particles(Particle_System* ps, float dt, Rectangle bounds) {
+	update_particle_emitters(ps, dt);	
+
+	Particle_Update_Job job = {
+		.ps = ps,
+		.dt = dt,
+		.bounds = bounds,
+		.seed = random_u32(&ps->random),
+	};
+	parallel_for(ps->jobs, ps->particle_count, PARTICLE_JOB_CHUNK, update_particle_chunk, &job);
+
+	remove_expired_particles(ps);
+}
+
+// Resolve each particle's collider once and bin it in the grid,
+// so every displace_particles call this tick can reuse them
+void update_particle_colliders(Particle_System* ps, Rectangle bounds) {
+	reset_spatial_grid(ps->grid, bounds);
+
+	for (int p = 0; p < ps->particle_count; p++) {
+		Transform2D transform = get_particle_transform(ps, p);
+		Collider* collider = ps->colliders + p;
+		*collider = get_collider(transform, get_particle_shape(ps, p, transform.scale));
+
+		if (collider->type != SHAPE_TYPE_UNDEFINED) {
+			spatial_grid_insert(ps->grid, p, collider->position, collider->radius + PARTICLE_GRID_PADDING);
+		}
 	}
 }
 
-void displace_particles(Particle_System* ps, Transform2D transform, Game_Shape shape) {
-	for (Particle* p = ps->particles; p != ps->particles+ps->particle_count; p++) {
+// Push particles out of collider. Only particles binned near it are tested, and since each test
+// only moves its own particle they don't need to be in array order.
+void displace_particles(Particle_System* ps, Collider* collider) {
+	if (collider->type == SHAPE_TYPE_UNDEFINED) return;
+
+	int candidate_count = spatial_grid_query(ps->grid, collider->position, collider->radius, ps->candidates, ps->capacity, false);
+	for (int c = 0; c < candidate_count; c++) {
+		Uint32 i = ps->candidates[c];
 		Vector2 overlap = {0};
-		Game_Shape particle_shape = scale_game_shape(p->shape, p->scale);
 
-		if ( check_shape_collision(p->transform, particle_shape, transform, shape, &overlap)) {
-			p->x -= overlap.x;
-			p->y -= overlap.y;
+		if ( check_collider_collision(ps->colliders + i, collider, &overlap)) {
+			ps->x[i] -= overlap.x;
+			ps->y[i] -= overlap.y;
+			ps->colliders[i].position = (Vector2){ps->x[i], ps->y[i]};
+			// Also bin the particle where it was pushed to. Stale entries only cost an extra test.
+			spatial_grid_insert(ps->grid, i, ps->colliders[i].position, ps->colliders[i].radius + PARTICLE_GRID_PADDING);
 
-			float magnitude = vector2_length(p->velocity);
+			Vector2 velocity = {ps->vx[i], ps->vy[i]};
+			float magnitude = vector2_length(velocity);
 
-			p->velocity = normalize_vector2(p->velocity);
+			velocity = normalize_vector2(velocity);
 
 			Vector2 new_v = {-overlap.x, -overlap.y};//subtract_vector2(p->position, entity->position);
 					new_v = normalize_vector2(new_v);
-					new_v = add_vector2(new_v, p->velocity);
+					new_v = add_vector2(new_v, velocity);
 					new_v = normalize_vector2(new_v);
 			
-			p->velocity = scale_vector2(new_v, magnitude / 2.0f);
+			velocity = scale_vector2(new_v, magnitude / 2.0f);
+			ps->vx[i] = velocity.x;
+			ps->vy[i] = velocity.y;
+		}
+	}
+}
+
+// Get the sprite batch for texture, submitting and reusing a batch if every one is taken
+static Render_Batch* get_particle_sprite_batch(Particle_System* ps, SDL_Texture* texture) {
+	Render_Batch* result = 0;
+
+	for (int i = 0; i < PARTICLE_SPRITE_BATCHES; i++) {
+		Render_Batch* batch = ps->sprite_batches + i;
+		if (batch->texture == texture) {
+			result = batch;
+			break;
+		} else if (batch->texture == NULL) {
+			result = batch;
+			break;
 		}
 	}
+
+	if (result == NULL) {
+		result = ps->sprite_batches + PARTICLE_SPRITE_BATCHES-1;
+		render_batch_submit(result);
+	}
+
+	if (result->texture != texture) {
+		result->texture = texture;
+		result->texture_size = platform_get_texture_dimensions(texture);
+	}
+
+	return result;
 }
 
-void draw_particles(Particle_System* ps, Game_Assets* assets) {
+// Sprite particles are drawn with one geometry call per texture, then shape particles with one more
+void draw_particles(Particle_System* ps) {
 	Particle* particle;
 	for (int p = 0; p < ps->particle_count; p++) {
 		particle = ps->particles + p;
-		if (particle->timer <= 0) continue;
-
-		float scale = SDL_clamp(particle->timer / (float)PARTICLE_LIFETIME, 0.0f, 1.0f);
+		if (ps->timers[p] <= 0) continue;
 
-		particle->sx = scale;
-		particle->sy = scale;
+		Transform2D transform = get_particle_transform(ps, p);
 
-		if (particle->sprite.texture_name) {
-			render_draw_game_sprite(assets, &particle->sprite, particle->transform, 1);
+		if (particle->texture) {
+			Render_Batch* batch = get_particle_sprite_batch(ps, particle->texture);
+			Vector2 size = {particle->src_rect.w * transform.sx, particle->src_rect.h * transform.sy};
+			render_batch_copy(batch, particle->src_rect, batch->texture_size, transform.position, size, transform.angle);
 		} else {
-			Game_Shape 	shape = particle->shape;
-			shape = scale_game_shape(shape, particle->scale);
+			Game_Shape shape = get_particle_shape(ps, p, transform.scale);
 
 			if (shape.type == SHAPE_TYPE_RECT) {
 				shape.rectangle.x = -shape.rectangle.w/2.0f;
@@ -122,200 +508,233 @@ void draw_particles(Particle_System* ps, Game_Assets* assets) {
 
 			shape = rotate_game_shape(shape, particle->angle);
 
-			render_fill_game_shape(particle->position, shape, particle->color);
+			render_batch_fill_game_shape(&ps->shape_batch, transform.position, shape, particle->color);
 		}
 	}
-}
 
-void init_particle(Particle* p, Game_Shape_Types shape) {
-	*p = (Particle) {0};
-	switch(shape) {
-		case SHAPE_TYPE_RECT: 	{
-			p->shape.rectangle.x = -PARTICLE_MAX_START_RADIUS;
-			p->shape.rectangle.y = -PARTICLE_MAX_START_RADIUS;
-			p->shape.rectangle.w = (float)PARTICLE_MAX_START_RADIUS*2.0f;
-			p->shape.rectangle.h = (float)PARTICLE_MAX_START_RADIUS*2.0f;
-		} break;
-		
-		case SHAPE_TYPE_CIRCLE: {
-			p->shape.radius = PARTICLE_MAX_START_RADIUS;
-		} break;
-
-		case SHAPE_TYPE_POLY2D: {
-			p->shape.type = SHAPE_TYPE_POLY2D;
-			p->shape.polygon = generate_poly2D(5, PARTICLE_MAX_START_RADIUS, PARTICLE_MAX_START_RADIUS/2);
-		} break;
+	for (int i = 0; i < PARTICLE_SPRITE_BATCHES; i++) {
+		render_batch_submit(ps->sprite_batches + i);
+		ps->sprite_batches[i].texture = 0;
 	}
-	p->shape.type = shape;
-	p->timer = PARTICLE_LIFETIME,
-	p->color = DEFAULT_PARTICLE_COLOR,
-	p->sx = p->sy = 1.0f;
+	render_batch_submit(&ps->shape_batch);
 }
 
+void init_particle(Particle_System* ps, Uint32 id, Game_Shape_Types shape) {
+	Particle* p = ps->particles + id;
+	*p = (Particle) {
+		.scale = {1.0f, 1.0f},
+		.shape_type = shape,
+	};
+	p->color = DEFAULT_PARTICLE_COLOR;
+
+	ps->x[id] = ps->y[id] = 0;
+	ps->vx[id] = ps->vy[id] = 0;
+	ps->timers[id] = PARTICLE_LIFETIME;
+}
+
+// When the system is full, the particle closest to expiring is replaced
 Uint32 get_new_particle(Particle_System* ps) {
 	Uint32 result = 0;
 	if (ps->particle_count == 0) ps->particle_count++;
-	if (ps->particle_count < MAX_PARTICLES) {
+	if (ps->particle_count < ps->capacity) {
 		result = ps->particle_count++;
 	} else {
-		SDL_Log("get_new_particle(): max Particle count reached");
+		result = 1;
+		for (Uint32 p = 2; p < ps->particle_count; p++) {
+			if (ps->timers[p] < ps->timers[result]) {
+				result = p;
+			}
+		}
+		ps->stats.particles_evicted++;
 	}
 
 	return result;
 }
 
-Uint32 spawn_particle(Particle_System* ps, Game_Sprite* sprite, Game_Shape_Types shape) {
+// Pass a texture to draw the particle as src_rect of it instead of as a shape
+Uint32 spawn_particle(Particle_System* ps, SDL_Texture* texture, Rectangle src_rect, Game_Shape_Types shape) {
 	Uint32 result = get_new_particle(ps);
 	if (result) {
-		Particle* particle = ps->particles + result;
-		init_particle(particle, shape);
-		if (sprite) particle->sprite = *sprite;
+		init_particle(ps, result, shape);
+		ps->particles[result].texture = texture;
+		ps->particles[result].src_rect = src_rect;
 	}
 
 	return result;
 }
 	
-static float random_particle_radius() {
-	float result = PARTICLE_MIN_START_RADIUS + SDL_floorf(randomf() * (PARTICLE_MAX_START_RADIUS - PARTICLE_MIN_START_RADIUS));
+static float random_particle_radius(Random_Series* series) {
+	float result = PARTICLE_MIN_START_RADIUS + SDL_floorf(random_float(series) * (PARTICLE_MAX_START_RADIUS - PARTICLE_MIN_START_RADIUS));
 		
 	return result;
 }
 
-static RGBA_Color random_color(RGBA_Color* colors, Uint32 color_count) {
-	RGBA_Color result = {0};
-	if (colors == 0 || color_count == 0) {
-		RGBA_Color default_color = DEFAULT_PARTICLE_COLOR;
-		color_count = 1;
-		colors = &default_color;
+static RGBA_Color random_color(Random_Series* series, RGBA_Color* colors, Uint32 color_count) {
+	RGBA_Color result = DEFAULT_PARTICLE_COLOR;
+	if (colors && color_count) {
+		result = colors[ (Uint32)(random_float(series) * (color_count)) ]; 
+	} else {
+		random_float(series); // Keep the series advancing the same way with or without colors
 	}
 
-	result = colors[ (Uint32)(randomf() * (color_count)) ]; 
 	return result;
 }
 
-void randomize_particle(Particle* p, RGBA_Color* colors, Uint32 color_count) {
-	float angle = randomf() * 360.0f;
+// Pick p's shape template and color, and return a random direction
+static Vector2 roll_particle(Particle_System* ps, Random_Series* series, Particle* p, RGBA_Color* colors, Uint32 color_count) {
+	// One roll picks both a shape template, skipping the default, and a direction
+	Uint32 roll = random_u32(series);
+	p->shape_template = 1 + (roll & 0xffff) % (PARTICLE_SHAPE_TEMPLATES-1);
+	p->color = random_color(series, colors, color_count); 
 
-	float radius = random_particle_radius();
-	switch(p->shape.type) {
-		case SHAPE_TYPE_CIRCLE: {
-			p->shape.radius = radius;
-		} break;
-		
-		case SHAPE_TYPE_RECT: {
-			p->shape.rectangle.x = 0.0f;
-			p->shape.rectangle.y = 0.0f;
-			p->shape.rectangle.w =  radius*2.0f;
-			p->shape.rectangle.h =  radius*2.0f;
-		} break;
-
-		case SHAPE_TYPE_POLY2D: {
-			int vert_count = SDL_clamp(3 + (randomf() * 5.0f), 3, MAX_POLY2D_VERTS);
-			float angle_increment = 360.0f / (float)vert_count;
-
-			float angle = 0;
-			for (int v = 0; v < vert_count; v++) {
-
-				p->shape.polygon.vertices[v] = (Vector2) {
-					cos_deg(angle) * radius,
-					sin_deg(angle) * radius,
-				};
+	Vector2 result = ps->directions[(roll >> 16) % PARTICLE_DIRECTIONS];
+	return result;
+}
 
-				angle += angle_increment;
-				radius = random_particle_radius();
-			}
-		} break;
-		default: { break; }
-	}
-	p->color = random_color(colors, color_count); 
-	p->vx = cos_deg(angle) * (float)PARTICLE_SPEED;
-	p->vy = sin_deg(angle) * (float)PARTICLE_SPEED;
+void randomize_particle(Particle_System* ps, Uint32 id, RGBA_Color* colors, Uint32 color_count) {
+	Vector2 direction = roll_particle(ps, &ps->random, ps->particles + id, colors, color_count);
+	ps->vx[id] = direction.x * (float)PARTICLE_SPEED;
+	ps->vy[id] = direction.y * (float)PARTICLE_SPEED;
 }
 
-void explode_at_point(Particle_System* ps, float x, float y, RGBA_Color* colors, Uint32 num_colors, Game_Sprite* sprite, Game_Shape_Types shape) {
+void explode_at_point(Particle_System* ps, float x, float y, RGBA_Color* colors, Uint32 num_colors, Game_Shape_Types shape) {
 //	if (force != 0) {force_circle(x, x, 120, force); }
-	for (int p = 0; p < EXPLOSION_STARTING_PARTICLES; p++) {
-		Uint32 id = spawn_particle(ps, sprite, shape);
+	int particle_count = (int)SDL_ceilf(EXPLOSION_STARTING_PARTICLES * ps->budget_scale);
+	for (int p = 0; p < particle_count; p++) {
+		Uint32 id = spawn_particle(ps, 0, (Rectangle){0}, shape);
 		if (id) {
-			Particle* p = ps->particles + id;
-			randomize_particle(p, colors, num_colors);
-			p->x = x;
-			p->y = y;
+			randomize_particle(ps, id, colors, num_colors);
+			ps->x[id] = x;
+			ps->y[id] = y;
 		}
 
 	}
 }
 
 // TO-DO: Fix broken particle emitters
-// Maybe need to reserve zero index?
 Uint32 get_new_particle_emitter(Particle_System* ps) {
-	Uint32 result = 0;
+	Uint32 index = 0;
 	if (ps->dead_emitter_count > 0) {
 		ps->dead_emitter_count--;
-		result = ps->dead_emitters[ps->dead_emitter_count];
-	} else if (ps->emitter_count < array_length(ps->emitters)) {
-		result = ps->emitter_count++;
+		index = ps->dead_emitters[ps->dead_emitter_count];
+	} else if (ps->emitter_count < ps->emitter_capacity) {
+		index = ps->emitter_count++;
 	} else {
-		SDL_Log("get_get_new_particle_emitter(): Particle emitter maximum reached");
+		ps->stats.emitters_dropped++;
 	}
 
-	if (result) {
-		*(ps->emitters + result) = (Particle_Emitter) {
+	Uint32 result = 0;
+	if (index) {
+		*(ps->emitters + index) = (Particle_Emitter) {
 			.scale = {1.0f,1.0f},
 		};
+		result = index | ((Uint32)ps->emitter_generations[index] << EMITTER_INDEX_BITS);
 	}
 
 	return result;
 }
 
-Particle_Emitter* get_particle_emitter(Particle_System* ps, Uint32 index) {
+Particle_Emitter* get_particle_emitter(Particle_System* ps, Uint32 handle) {
 	Particle_Emitter* result = 0;
+	Uint32 index = handle & EMITTER_INDEX_MASK;
 
-	if (index && index < ps->emitter_count) result = ps->emitters + index;
+	if (	index && index < ps->emitter_count 
+		&& ps->emitter_generations[index] == (handle >> EMITTER_INDEX_BITS)
+		&& ps->emitters[index].state != EMITTER_STATE_DEAD
+	) {
+		result = ps->emitters + index;
+	}
 
 	return result;
 }
 
-void remove_particle_emitter(Particle_System* ps, Uint32 index) {
-	if (index > ps->emitter_count) return;
-	if (index == ps->emitter_count-1) {
-		ps->emitter_count--;
-	} else {
-		ps->emitters[index].state = EMITTER_STATE_DEAD;
-		ps->dead_emitters[ps->dead_emitter_count] = index;
-		ps->dead_emitter_count++;
+void remove_particle_emitter(Particle_System* ps, Uint32 handle) {
+	Particle_Emitter* emitter = get_particle_emitter(ps, handle);
+	if (emitter == NULL) return;
+
+	Uint32 index = handle & EMITTER_INDEX_MASK;
+	ps->emitter_generations[index]++;
+	emitter->state = EMITTER_STATE_DEAD;
+	ps->dead_emitters[ps->dead_emitter_count] = index;
+	ps->dead_emitter_count++;
+}
+
+typedef struct Emitter_Job {
+	Particle_System* ps;
+	Uint64 seed;
+} Emitter_Job;
+
+// Fill each emitter's staging slots, using a random series of its own
+static void stage_emitter_particles(void* data, Uint32 first, Uint32 last) {
+	Emitter_Job* job = data;
+	Particle_System* ps = job->ps;
+
+	for (Uint32 emitter_index = first; emitter_index < last; emitter_index++) {
+		Uint32 slot = ps->emitter_spawn_offsets[emitter_index];
+		Uint32 end = ps->emitter_spawn_offsets[emitter_index+1];
+		if (slot == end) continue;
+
+		Particle_Emitter* emitter = ps->emitters + emitter_index;
+		Random_Series series;
+		seed_random_series(&series, job->seed, emitter_index);
+
+		Vector2 velocity = {cos_deg(emitter->angle) * emitter->speed, sin_deg(emitter->angle) * emitter->speed};
+		for (; slot < end; slot++) {
+			Staged_Particle* staged = ps->staged + slot;
+			staged->particle = (Particle) {
+				.scale = emitter->scale,
+				.shape_type = emitter->shape,
+			};
+			roll_particle(ps, &series, &staged->particle, emitter->colors, emitter->color_count);
+			staged->position = emitter->position;
+			staged->velocity = velocity;
+		}
 	}
 }
 
 static void update_particle_emitters(Particle_System* ps, float dt) {
-	for (int emitter_index = 1; emitter_index < ps->emitter_count; emitter_index++) {
+	// Count every emitter's particles first, so each gets fixed staging slots
+	Uint32 staged_count = 0;
+	for (int emitter_index = 0; emitter_index < ps->emitter_count; emitter_index++) {
+		ps->emitter_spawn_offsets[emitter_index] = staged_count;
+
 		Particle_Emitter* emitter = ps->emitters + emitter_index;
-		if (emitter->state != EMITTER_STATE_ACTIVE) continue;
+		if (emitter_index == 0 || emitter->state != EMITTER_STATE_ACTIVE) continue;
 		
-		emitter->counter += emitter->density * dt;
+		emitter->counter += emitter->density * ps->budget_scale * dt;
 
 		if (emitter->counter >= 1.0f) {
-			int particles_to_emit = (int)emitter->counter;
-			while (particles_to_emit) {
-				Uint32 id = spawn_particle(ps, 0, emitter->shape);
-				if (id) {
-					Particle* p = ps->particles + id;
-					randomize_particle(p, emitter->colors, emitter->color_count);
-
-					p->shape = scale_game_shape(p->shape, emitter->scale);
-					
-					p->x = emitter->x;
-					p->y = emitter->y;
-
-					p->vx = cos_deg(emitter->angle) * emitter->speed;
-					p->vy = sin_deg(emitter->angle) * emitter->speed;
-				}
-				particles_to_emit--;
-			}
-
+			staged_count += (int)emitter->counter;
 			emitter->counter -= (int)emitter->counter;
 		}
 	}
+	ps->emitter_spawn_offsets[ps->emitter_count] = staged_count;
+	if (staged_count == 0) return;
+
+	if (staged_count > ps->staged_capacity) {
+		ps->staged_capacity = SDL_max(staged_count, ps->staged_capacity * 2);
+		ps->staged = SDL_realloc(ps->staged, ps->staged_capacity * sizeof(Staged_Particle));
+	}
+
+	Emitter_Job job = {
+		.ps = ps,
+		.seed = random_u32(&ps->random),
+	};
+	parallel_for(ps->jobs, ps->emitter_count, EMITTER_JOB_CHUNK, stage_emitter_particles, &job);
+
+	// Add staged particles in emitter order, so eviction doesn't depend on which thread staged what
+	for (Uint32 s = 0; s < staged_count; s++) {
+		Staged_Particle* staged = ps->staged + s;
+		Uint32 id = get_new_particle(ps);
+		if (id) {
+			ps->particles[id] = staged->particle;
+			ps->timers[id] = PARTICLE_LIFETIME;
+			ps->x[id] = staged->position.x;
+			ps->y[id] = staged->position.y;
+			ps->vx[id] = staged->velocity.x;
+			ps->vy[id] = staged->velocity.y;
+		}
+	}
 }
 
 void explode_sprite(Game_Assets* assets, Particle_System* ps, Game_Sprite* sprite, float x, float y, float angle, int pieces) {
@@ -324,32 +743,27 @@ void explode_sprite(Game_Assets* assets, Particle_System* ps, Game_Sprite* sprit
 
 	Vector2 sprite_offset = rotate_vector2(sprite->offset, angle);
 
-	Game_Sprite* chunks = divide_sprite(assets, sprite, pieces);
-
-	float radius = (chunks[0].src_rect.w + chunks[0].src_rect.h) / 2;
-	int cHalf = pieces / 2;
+	Sprite_Chunks* chunks = get_sprite_chunks(assets, sprite, pieces);
+	if (chunks == NULL) return;
 
 	// Create explosion using chunks as particle sprites
-	for (int chunk_index = 0; chunk_index < pieces; chunk_index++) {
-		Uint32 particle_id = spawn_particle(ps, chunks + chunk_index, SHAPE_TYPE_CIRCLE);
+	for (int chunk_index = 0; chunk_index < chunks->count; chunk_index++) {
+		Uint32 particle_id = spawn_particle(ps, chunks->texture, chunks->rects[chunk_index], SHAPE_TYPE_CIRCLE);
 		if (particle_id) {
 			const float random_deviation = 30.0f;
 
 			float chunk_angle = angle + 180.0f + (chunk_index * angle_division);
-				chunk_angle += random_deviation/2.0f - (randomf() * random_deviation);
+				chunk_angle += random_deviation/2.0f - (random_float(&ps->random) * random_deviation);
 			float vx = cos_deg(chunk_angle) * (float)PARTICLE_SPEED;
 			float vy = sin_deg(chunk_angle) * (float)PARTICLE_SPEED;
 
-			Particle* particle = ps->particles + particle_id;
-			randomize_particle(particle, 0, 0);
-			particle->timer = PARTICLE_LIFETIME;
-			particle->angle = angle;
-			particle->x = x + sprite_offset.x;
-			particle->y = y + sprite_offset.y;
-			particle->vx = vx;
-			particle->vy = vy;
+			randomize_particle(ps, particle_id, 0, 0);
+			ps->timers[particle_id] = PARTICLE_LIFETIME;
+			ps->particles[particle_id].angle = angle * (float)(int)sprite->rotation_enabled;
+			ps->x[particle_id] = x + sprite_offset.x;
+			ps->y[particle_id] = y + sprite_offset.y;
+			ps->vx[particle_id] = vx;
+			ps->vy[particle_id] = vy;
 		}
 	}
-
-	SDL_free(chunks);
 }
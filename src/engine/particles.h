@@ -2,27 +2,41 @@
 #define PARTICLES_H
 
 #include "types.h"
+#include "jobs.h"
 
-Particle_System*	new_particle_system		(void);
+typedef struct Particle_Stats {
+	Uint32 particles_evicted; // Live particles replaced because the system was full
+	Uint32 emitters_dropped; // Emitter requests refused because every slot was in use
+} Particle_Stats;
+
+Particle_System*	new_particle_system		(Uint32 capacity, Uint32 emitter_capacity, Uint64 seed);
+Particle_Stats		get_particle_stats		(Particle_System* ps);
+void			end_particle_stats_frame	(Particle_System* ps);
+void			set_particle_job_pool		(Particle_System* ps, Job_Pool* pool);
+void			govern_particle_budget		(Particle_System* ps, float frame_ms, float budget_ms);
+float			get_particle_budget_scale	(Particle_System* ps);
 void			reset_particle_system		(Particle_System* ps);
-void			update_particles		(Particle_System* ps, float dt);
-void			draw_particles			(Particle_System* ps, Game_Assets* assets);
+Uint32			get_particle_count		(Particle_System* ps);
+Uint32			hash_particle_system		(Particle_System* ps, Uint32 hash);
+void			set_particle_stable_order	(Particle_System* ps, SDL_bool stable);
+void			update_particles		(Particle_System* ps, float dt, Rectangle bounds);
+void			draw_particles			(Particle_System* ps);
 
-void			init_particle			(Particle* p, Game_Shape_Types shape);
+void			init_particle			(Particle_System* ps, Uint32 id, Game_Shape_Types shape);
 Uint32			get_new_particle		(Particle_System* ps);
-Uint32			spawn_particle			(Particle_System* ps, Game_Sprite* sprite, Game_Shape_Types shape);
-void			randomize_particle		(Particle* p, RGBA_Color* colors, Uint32 color_count);
+Uint32			spawn_particle			(Particle_System* ps, SDL_Texture* texture, Rectangle src_rect, Game_Shape_Types shape);
+void			randomize_particle		(Particle_System* ps, Uint32 id, RGBA_Color* colors, Uint32 color_count);
 
 Uint32			get_new_particle_emitter	(Particle_System* ps);
-Particle_Emitter*	get_particle_emitter		(Particle_System* ps, Uint32 index);
-void			remove_particle_emitter		(Particle_System* ps, Uint32 index);
+Particle_Emitter*	get_particle_emitter		(Particle_System* ps, Uint32 handle);
+void			remove_particle_emitter		(Particle_System* ps, Uint32 handle);
 
-void			displace_particles		(Particle_System* ps, Transform2D transform, Game_Shape shape);
-void			wrap_particles			(Particle_System* ps, Rectangle bounds);
+void			update_particle_colliders	(Particle_System* ps, Rectangle bounds);
+void			displace_particles		(Particle_System* ps, Collider* collider);
 void			explode_at_point		(Particle_System* ps,
 							 float x, float y, 
 							 RGBA_Color* colors, Uint32 num_colors, 
-							 Game_Sprite* sprite, Game_Shape_Types shape);
+							 Game_Shape_Types shape);
 void			explode_sprite			(Game_Assets* assets, Particle_System* ps, 
 							 Game_Sprite* sprite, 
 							 float x, float y, float angle,
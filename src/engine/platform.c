@@ -9,9 +9,12 @@
 #include "assets.c"
 #include "graphics.c"
 #include "input.c"
+#include "jobs.c"
 #include "lerp.c"
 #include "math.c"
 #include "particles.c"
+#include "replay.c"
+#include "spatial_grid.c"
 #include "ui.c"
 
 static SDL_Window *	window = 0;
@@ -72,6 +75,7 @@ SDL_Texture* platform_create_texture_from_surface(SDL_Surface* surface) {
 }
 
 void platform_destroy_texture(SDL_Texture* texture) {
+	platform_flush_render_queue(); // Queued draws may use texture
 	SDL_DestroyTexture(texture);
 }
 
@@ -81,8 +85,198 @@ int platform_set_texture_alpha(SDL_Texture* texture, uint8_t alpha) {
 	return result;
 }
 
+// Deferred rendering appends every draw to a batch of triangles for its texture and blend mode.
+// A draw can join an earlier batch with the same state as long as it doesn't overlap anything
+// queued after that batch, so the result looks the same as drawing immediately.
+// Batches are drawn in order, with one SDL_RenderGeometry call each, whenever the render target,
+// clip rect or renderer state changes, pixels are read, and before presenting.
+#define RENDER_QUEUE_BATCHES 32
+
+typedef struct Render_Queue_Batch {
+	Render_Batch geometry;
+	SDL_BlendMode blend_mode;
+	Rectangle bounds;
+} Render_Queue_Batch;
+
+static struct {
+	SDL_bool deferred;
+	RGBA_Color draw_color; // SDL's draw color is only set when something needs it
+	SDL_BlendMode draw_blend_mode;
+
+	Render_Queue_Batch batches[RENDER_QUEUE_BATCHES];
+	int batch_count;
+
+	Render_Stats stats; // This frame's
+	Render_Stats last_stats; // The last presented frame's
+} render_queue = {
+	.draw_color = {255, 255, 255, 255},
+	.draw_blend_mode = SDL_BLENDMODE_BLEND,
+};
+
+void platform_set_deferred_rendering(SDL_bool deferred) {
+	platform_flush_render_queue();
+
+	// Draw color changes were only cached while deferred
+	if (render_queue.deferred && !deferred && renderer) {
+		RGBA_Color color = render_queue.draw_color;
+		SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
+	}
+	render_queue.deferred = deferred;
+}
+
+SDL_bool platform_get_deferred_rendering(void) {
+	return render_queue.deferred;
+}
+
+// Counts for the last frame that was presented
+Render_Stats platform_get_render_stats(void) {
+	return render_queue.last_stats;
+}
+
+static void end_render_stats_frame(void) {
+	render_queue.last_stats = render_queue.stats;
+	render_queue.stats = (Render_Stats){0};
+}
+
+// Draw every queued batch in order. Returns the number of batches drawn.
+int platform_flush_render_queue(void) {
+	int result = 0;
+
+	for (int i = 0; i < render_queue.batch_count; i++) {
+		Render_Queue_Batch* batch = render_queue.batches + i;
+		Render_Batch* geometry = &batch->geometry;
+
+		// Draw with the blend mode the texture had when queued, then put back the one it has now
+		SDL_BlendMode texture_blend_mode = batch->blend_mode;
+		if (geometry->texture) {
+			SDL_GetTextureBlendMode(geometry->texture, &texture_blend_mode);
+			if (texture_blend_mode != batch->blend_mode) {
+				SDL_SetTextureBlendMode(geometry->texture, batch->blend_mode);
+			}
+		}
+
+		SDL_RenderGeometry(renderer, geometry->texture, geometry->vertices, geometry->vertex_count, geometry->indices, geometry->index_count);
+		if (geometry->texture && texture_blend_mode != batch->blend_mode) {
+			SDL_SetTextureBlendMode(geometry->texture, texture_blend_mode);
+		}
+		render_batch_clear(geometry);
+		render_queue.stats.sdl_calls++;
+		result++;
+	}
+	render_queue.stats.batches += result;
+	render_queue.batch_count = 0;
+
+	return result;
+}
+
+static inline SDL_bool rects_overlap(Rectangle a, Rectangle b) {
+	SDL_bool result = (a.x < b.x + b.w && b.x < a.x + a.w && a.y < b.y + b.h && b.y < a.y + a.h);
+	return result;
+}
+
+// Append vertices, and indices into them, to the batch for texture's current state.
+// Without indices, every three vertices are a triangle.
+static void queue_geometry(SDL_Texture* texture, const SDL_Vertex* vertices, int num_vertices, const int* indices, int num_indices) {
+	if (num_vertices <= 0) return;
+
+	float min_x = vertices[0].position.x, max_x = min_x;
+	float min_y = vertices[0].position.y, max_y = min_y;
+	for (int i = 1; i < num_vertices; i++) {
+		min_x = SDL_min(min_x, vertices[i].position.x);
+		max_x = SDL_max(max_x, vertices[i].position.x);
+		min_y = SDL_min(min_y, vertices[i].position.y);
+		max_y = SDL_max(max_y, vertices[i].position.y);
+	}
+	// Pad by a pixel, since touching edges can still share pixels
+	Rectangle bounds = {min_x - 1.0f, min_y - 1.0f, max_x - min_x + 2.0f, max_y - min_y + 2.0f};
+
+	SDL_BlendMode blend_mode = render_queue.draw_blend_mode;
+	if (texture) {
+		SDL_GetTextureBlendMode(texture, &blend_mode);
+	}
+
+	// Newest first, stopping at the first batch this would have to be drawn underneath
+	Render_Queue_Batch* batch = 0;
+	for (int i = render_queue.batch_count-1; i >= 0; i--) {
+		Render_Queue_Batch* queued = render_queue.batches + i;
+		if (queued->geometry.texture == texture && queued->blend_mode == blend_mode) {
+			batch = queued;
+			break;
+		} else if (rects_overlap(queued->bounds, bounds)) {
+			break;
+		}
+	}
+
+	if (batch == NULL) {
+		if (render_queue.batch_count == RENDER_QUEUE_BATCHES) {
+			platform_flush_render_queue();
+		}
+		batch = render_queue.batches + render_queue.batch_count++;
+		batch->geometry.texture = texture;
+		batch->blend_mode = blend_mode;
+		batch->bounds = bounds;
+	} else {
+		float right = SDL_max(batch->bounds.x + batch->bounds.w, bounds.x + bounds.w);
+		float bottom = SDL_max(batch->bounds.y + batch->bounds.h, bounds.y + bounds.h);
+		batch->bounds.x = SDL_min(batch->bounds.x, bounds.x);
+		batch->bounds.y = SDL_min(batch->bounds.y, bounds.y);
+		batch->bounds.w = right - batch->bounds.x;
+		batch->bounds.h = bottom - batch->bounds.y;
+	}
+
+	Render_Batch* geometry = &batch->geometry;
+	int index_count = (indices) ? num_indices : num_vertices;
+	int first = render_batch_reserve(geometry, num_vertices, index_count);
+	SDL_memcpy(geometry->vertices + first, vertices, sizeof(SDL_Vertex) * num_vertices);
+
+	int* batch_indices = geometry->indices + geometry->index_count;
+	for (int i = 0; i < index_count; i++) {
+		batch_indices[i] = first + ((indices) ? indices[i] : i);
+	}
+	geometry->index_count += index_count;
+}
+
+// Queue an untextured quad with corners in order around its edge
+static void queue_quad(Vector2 a, Vector2 b, Vector2 c, Vector2 d, RGBA_Color color) {
+	SDL_Color sdl_color = {color.r, color.g, color.b, color.a};
+	SDL_Vertex vertices[4] = {
+		{ {a.x, a.y}, sdl_color, {1.0f, 1.0f} },
+		{ {b.x, b.y}, sdl_color, {1.0f, 1.0f} },
+		{ {c.x, c.y}, sdl_color, {1.0f, 1.0f} },
+		{ {d.x, d.y}, sdl_color, {1.0f, 1.0f} },
+	};
+	int indices[6] = {0, 1, 2, 0, 2, 3};
+
+	queue_geometry(0, vertices, 4, indices, 6);
+}
+
+static void queue_rect(float x, float y, float w, float h, RGBA_Color color) {
+	queue_quad((Vector2){x, y}, (Vector2){x + w, y}, (Vector2){x + w, y + h}, (Vector2){x, y + h}, color);
+}
+
+// Lines are one pixel wide quads through the centers of the pixels at each end
+static void queue_line(Vector2 start, Vector2 end, RGBA_Color color) {
+	Vector2 a = {start.x + 0.5f, start.y + 0.5f};
+	Vector2 b = {end.x + 0.5f, end.y + 0.5f};
+	Vector2 direction = subtract_vector2(b, a);
+
+	if (direction.x == 0 && direction.y == 0) {
+		queue_rect(start.x, start.y, 1.0f, 1.0f, color);
+		return;
+	}
+
+	direction = scale_vector2(normalize_vector2(direction), 0.5f);
+	Vector2 normal = {-direction.y, direction.x};
+	a = subtract_vector2(a, direction);
+	b = add_vector2(b, direction);
+
+	queue_quad(add_vector2(a, normal), add_vector2(b, normal), subtract_vector2(b, normal), subtract_vector2(a, normal), color);
+}
+
 int platform_render_read_pixels(const Rectangle* rect, Uint32 format, void* pixels, int pitch) {
+	platform_flush_render_queue();
 	int result = SDL_RenderReadPixels(renderer, (SDL_Rect*)rect, format, pixels, pitch);
+	render_queue.stats.sdl_calls++;
 
 	return result;
 }
@@ -91,7 +285,10 @@ int platform_set_render_target(SDL_Texture *texture) {
 	int result = -1;
 
 	if (renderer) {
+		platform_flush_render_queue();
 		result = SDL_SetRenderTarget(renderer, texture);
+		render_queue.stats.commands++;
+		render_queue.stats.sdl_calls++;
 	} else {
 		SDL_SetError("platform_set_render_target(): renderer does not exist.");
 	}
@@ -103,7 +300,20 @@ int platform_render_clear(void) {
 	int result = -1;
 
 	if (renderer) {
+		render_queue.stats.commands++;
+		if (render_queue.deferred) {
+			// Queued draws would be cleared anyway
+			for (int i = 0; i < render_queue.batch_count; i++) {
+				render_batch_clear(&render_queue.batches[i].geometry);
+			}
+			render_queue.batch_count = 0;
+
+			RGBA_Color color = render_queue.draw_color;
+			SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
+			render_queue.stats.sdl_calls++;
+		}
 		result = SDL_RenderClear(renderer);
+		render_queue.stats.sdl_calls++;
 	} else {
 		SDL_SetError("platform_render_clear(): renderer does not exist.");
 	}
@@ -124,11 +334,9 @@ Vector2 platform_get_texture_dimensions(SDL_Texture* texture) {
 	return result;
 }
 
+// Every draw color change goes through platform_set_render_draw_color, so the cache is always current
 RGBA_Color platform_get_render_draw_color(void) {
-	RGBA_Color result;
-	if (renderer) {
-		SDL_GetRenderDrawColor(renderer, &result.r, &result.g, &result.b, &result.a);
-	}
+	RGBA_Color result = render_queue.draw_color;
 	return result;
 }
 
@@ -136,7 +344,14 @@ int platform_set_render_draw_color(RGBA_Color color) {
 	int result = -1;
 	
 	if (renderer) {
-		result = SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
+		render_queue.draw_color = color;
+		render_queue.stats.commands++;
+		if (render_queue.deferred) {
+			result = 0;
+		} else {
+			result = SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
+			render_queue.stats.sdl_calls++;
+		}
 	} else {
 		SDL_SetError("platform_render_set_draw_color(): renderer does not exist.");
 	}
@@ -144,6 +359,49 @@ int platform_set_render_draw_color(RGBA_Color color) {
 	return result;
 }
 
+// Queue texture as a quad placed like SDL_RenderCopyExF() would, with its color and alpha mods in the vertex colors
+static void queue_copy(SDL_Texture* texture, const SDL_Rect* src_rect, const Rectangle* dst_rect, double angle, const Vector2* center, SDL_RendererFlip flip) {
+	int texture_w, texture_h;
+	if (SDL_QueryTexture(texture, NULL, NULL, &texture_w, &texture_h) != 0 || texture_w <= 0 || texture_h <= 0) return;
+
+	SDL_Rect src = (src_rect) ? *src_rect : (SDL_Rect){0, 0, texture_w, texture_h};
+	float u0 = (float)src.x / (float)texture_w, u1 = (float)(src.x + src.w) / (float)texture_w;
+	float v0 = (float)src.y / (float)texture_h, v1 = (float)(src.y + src.h) / (float)texture_h;
+	if (flip & SDL_FLIP_HORIZONTAL) {
+		float swap = u0; u0 = u1; u1 = swap;
+	}
+	if (flip & SDL_FLIP_VERTICAL) {
+		float swap = v0; v0 = v1; v1 = swap;
+	}
+
+	Vector2 pivot = (center) ? *center : (Vector2){dst_rect->w / 2.0f, dst_rect->h / 2.0f};
+	Vector2 origin = {dst_rect->x + pivot.x, dst_rect->y + pivot.y};
+	Vector2 corners[4] = {
+		{-pivot.x, -pivot.y},
+		{dst_rect->w - pivot.x, -pivot.y},
+		{dst_rect->w - pivot.x, dst_rect->h - pivot.y},
+		{-pivot.x, dst_rect->h - pivot.y},
+	};
+	SDL_FPoint tex_coords[4] = { {u0, v0}, {u1, v0}, {u1, v1}, {u0, v1} };
+
+	SDL_Color color = {255, 255, 255, 255};
+	SDL_GetTextureColorMod(texture, &color.r, &color.g, &color.b);
+	SDL_GetTextureAlphaMod(texture, &color.a);
+
+	SDL_Vertex vertices[4];
+	for (int i = 0; i < 4; i++) {
+		Vector2 corner = rotate_vector2(corners[i], (float)angle);
+		vertices[i] = (SDL_Vertex) {
+			.position = {origin.x + corner.x, origin.y + corner.y},
+			.color = color,
+			.tex_coord = tex_coords[i],
+		};
+	}
+	int indices[6] = {0, 1, 2, 0, 2, 3};
+
+	queue_geometry(texture, vertices, 4, indices, 6);
+}
+
 int platform_render_copy(SDL_Texture *texture, const Rectangle *src_rect, const Rectangle *dst_rect, const double angle, const Vector2 *center, const SDL_RendererFlip flip) {
 	int result = -1;
 
@@ -156,11 +414,19 @@ int platform_render_copy(SDL_Texture *texture, const Rectangle *src_rect, const
 			};
 			pi_src_rect = &int_src_rect;
 		}
+		render_queue.stats.commands++;
 		
-		if (angle || center || flip) {
-			result = SDL_RenderCopyExF(renderer, texture, pi_src_rect, (SDL_FRect*)dst_rect, angle, (SDL_FPoint*)center, flip);
+		if (render_queue.deferred && dst_rect) {
+			queue_copy(texture, pi_src_rect, dst_rect, angle, center, flip);
+			result = 0;
 		} else {
-			result = SDL_RenderCopyF  (renderer, texture, pi_src_rect, (SDL_FRect*)dst_rect);
+			platform_flush_render_queue();
+			if (angle || center || flip) {
+				result = SDL_RenderCopyExF(renderer, texture, pi_src_rect, (SDL_FRect*)dst_rect, angle, (SDL_FPoint*)center, flip);
+			} else {
+				result = SDL_RenderCopyF  (renderer, texture, pi_src_rect, (SDL_FRect*)dst_rect);
+			}
+			render_queue.stats.sdl_calls++;
 		}
 	} else {
 		SDL_SetError("platform_render_copy(): renderer does not exist.");
@@ -172,7 +438,16 @@ int platform_render_copy(SDL_Texture *texture, const Rectangle *src_rect, const
 int platform_render_draw_points (Vector2* points, int count) {
 	int result = -1;
 	if (renderer) {
-		result = SDL_RenderDrawPointsF(renderer, (SDL_FPoint*)points, count);
+		render_queue.stats.commands++;
+		if (render_queue.deferred) {
+			for (int i = 0; i < count; i++) {
+				queue_rect(points[i].x, points[i].y, 1.0f, 1.0f, render_queue.draw_color);
+			}
+			result = 0;
+		} else {
+			result = SDL_RenderDrawPointsF(renderer, (SDL_FPoint*)points, count);
+			render_queue.stats.sdl_calls++;
+		}
 	} else {
 		SDL_SetError("platform_render_draw_points(): renderer does not exist.");
 	}
@@ -184,7 +459,19 @@ int platform_render_draw_rect(Rectangle rect) {
 	int result = -1;
 
 	if (renderer) {	
-		result = SDL_RenderDrawRectF(renderer, (SDL_FRect*)&rect);
+		render_queue.stats.commands++;
+		if (render_queue.deferred) {
+			// The outline covers the rect's outermost pixels, like SDL_RenderDrawRectF()
+			RGBA_Color color = render_queue.draw_color;
+			queue_rect(rect.x, rect.y, rect.w, 1.0f, color);
+			queue_rect(rect.x, rect.y + rect.h - 1.0f, rect.w, 1.0f, color);
+			queue_rect(rect.x, rect.y + 1.0f, 1.0f, rect.h - 2.0f, color);
+			queue_rect(rect.x + rect.w - 1.0f, rect.y + 1.0f, 1.0f, rect.h - 2.0f, color);
+			result = 0;
+		} else {
+			result = SDL_RenderDrawRectF(renderer, (SDL_FRect*)&rect);
+			render_queue.stats.sdl_calls++;
+		}
 	} else {
 		SDL_SetError("platform_render_draw_rect(): renderer does not exist.");
 	}
@@ -195,10 +482,18 @@ int platform_render_draw_rect(Rectangle rect) {
 int platform_render_draw_lines(const Vector2 *points, int count) {
 	int result = -1;
 	if (renderer) {
-		if (count == 2) {
-			SDL_RenderDrawLineF(renderer, points[0].x, points[0].y, points[1].x, points[1].y);
+		render_queue.stats.commands++;
+		if (render_queue.deferred) {
+			for (int i = 0; i + 1 < count; i++) {
+				queue_line(points[i], points[i+1], render_queue.draw_color);
+			}
+			result = 0;
+		} else if (count == 2) {
+			result = SDL_RenderDrawLineF(renderer, points[0].x, points[0].y, points[1].x, points[1].y);
+			render_queue.stats.sdl_calls++;
 		} else {
-			SDL_RenderDrawLinesF(renderer, (const SDL_FPoint*)points, count);
+			result = SDL_RenderDrawLinesF(renderer, (const SDL_FPoint*)points, count);
+			render_queue.stats.sdl_calls++;
 		}
 	} else {
 		SDL_SetError("platform_render_draw_points(): renderer does not exist.");
@@ -211,7 +506,14 @@ int platform_render_fill_rect(Rectangle rect) {
 	int result = -1;
 
 	if (renderer) {	
-		result = SDL_RenderFillRectF(renderer, (SDL_FRect*)&rect);
+		render_queue.stats.commands++;
+		if (render_queue.deferred) {
+			queue_rect(rect.x, rect.y, rect.w, rect.h, render_queue.draw_color);
+			result = 0;
+		} else {
+			result = SDL_RenderFillRectF(renderer, (SDL_FRect*)&rect);
+			render_queue.stats.sdl_calls++;
+		}
 	} else {
 		SDL_SetError("platform_render_fill_rect(): renderer does not exist.");
 	}
@@ -223,7 +525,14 @@ int platform_render_geometry(SDL_Texture *texture, const SDL_Vertex* vertices, i
 	int result = -1;
 	
 	if (renderer) {
-		result = SDL_RenderGeometry(renderer, texture, vertices, num_vertices, indices, num_indices);
+		render_queue.stats.commands++;
+		if (render_queue.deferred) {
+			queue_geometry(texture, vertices, num_vertices, indices, num_indices);
+			result = 0;
+		} else {
+			result = SDL_RenderGeometry(renderer, texture, vertices, num_vertices, indices, num_indices);
+			render_queue.stats.sdl_calls++;
+		}
 	}
 
 	return result;
@@ -247,6 +556,24 @@ static void precise_delay(double ms) {
 	}
 }
 
+static void init_renderer_and_audio(Platform_State* platform) {
+	SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+
+	if (Mix_OpenAudio(48000, MIX_DEFAULT_FORMAT, 2, 512) != -1) {
+		Mix_AllocateChannels(12);
+	}
+
+	world_buffer = SDL_CreateTexture(
+		renderer, 
+		SDL_PIXELFORMAT_ARGB32, SDL_TEXTUREACCESS_TARGET, 
+		platform->world.x, platform->world.y
+	);
+	if (!world_buffer) {
+		SDL_Log("Creating world buffer failed. %s", SDL_GetError());
+		SDL_Quit();
+	}
+}
+
 void platform_init(Platform_State* platform) {
 	SDL_Init(SDL_INIT_EVERYTHING);
 	window = SDL_CreateWindow(
@@ -267,27 +594,38 @@ void platform_init(Platform_State* platform) {
 		SDL_LogError(0, "%s", SDL_GetError());
 		SDL_Quit();
 	}
-	SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
 
 	SDL_GameControllerEventState(SDL_ENABLE);
 
-	if (Mix_OpenAudio(48000, MIX_DEFAULT_FORMAT, 2, 512) != -1) {
-		Mix_AllocateChannels(12);
-	}
+	init_renderer_and_audio(platform);
+	platform->jobs = new_job_pool(platform->worker_count);
+	platform_set_deferred_rendering(platform->deferred_rendering);
+}
 
-	world_buffer = SDL_CreateTexture(
-		renderer, 
-		SDL_PIXELFORMAT_ARGB32, SDL_TEXTUREACCESS_TARGET, 
-		platform->world.x, platform->world.y
-	);
-	if (!world_buffer) {
-		SDL_Log("Creating world buffer failed. %s", SDL_GetError());
+// No window or audio device. Textures are backed by a software renderer drawing to an
+// offscreen surface and audio plays through SDL's dummy driver, so games can load
+// assets and run update_game as usual.
+void platform_init_headless(Platform_State* platform) {
+	SDL_SetHint(SDL_HINT_AUDIODRIVER, "dummy");
+	SDL_Init(SDL_INIT_TIMER | SDL_INIT_AUDIO);
+
+	SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0, platform->world.x, platform->world.y, 32, SDL_PIXELFORMAT_ARGB8888);
+	if (surface) {
+		renderer = SDL_CreateSoftwareRenderer(surface);
+	}
+	if (renderer == NULL) {
+		SDL_LogError(0, "%s", SDL_GetError());
 		SDL_Quit();
 	}
+
+	init_renderer_and_audio(platform);
+	platform->jobs = new_job_pool(platform->worker_count);
+	platform_set_deferred_rendering(platform->deferred_rendering);
 }
 
 #define TICK_RATE 60
 SDL_bool platform_update_and_render(Platform_State* platform, Platform_Game_State* game, Game_Input* input) {
+	Uint64 frame_start = SDL_GetPerformanceCounter();
 	double dt = (double)(platform->current_count - platform->last_count) / (double)SDL_GetPerformanceFrequency();
 	dt = dt/(1.0 / (double)TICK_RATE);
 
@@ -321,6 +659,27 @@ SDL_bool platform_update_and_render(Platform_State* platform, Platform_Game_Stat
 	if (is_key_released(input, SDL_SCANCODE_GRAVE)) {
 		SDL_Log("Break");
 	}
+
+	if (is_key_released(input, SDL_SCANCODE_F1)) {
+		Collision_Stats stats = get_collision_stats();
+		SDL_Log("Collision pairs: %u tested, %u rejected by bounds, %u sent to SAT", 
+			stats.pairs_tested, stats.pairs_rejected, stats.pairs_sat);
+		reset_collision_stats();
+
+		Particle_Stats particle_stats = get_particle_stats(game->particle_system);
+		SDL_Log("Last frame: %u particles evicted, %u emitters dropped, budget scale %.2f",
+			particle_stats.particles_evicted, particle_stats.emitters_dropped,
+			get_particle_budget_scale(game->particle_system));
+
+		Render_Stats render_stats = platform_get_render_stats();
+		SDL_Log("Last frame: %u render commands, %u SDL calls, %u batches (%s)",
+			render_stats.commands, render_stats.sdl_calls, render_stats.batches,
+			render_queue.deferred ? "deferred" : "immediate");
+	}
+
+	if (is_key_released(input, SDL_SCANCODE_F2)) {
+		platform_set_deferred_rendering(!render_queue.deferred);
+	}
 #endif
 	if (SDL_GetModState() & KMOD_ALT) {
 		if (is_key_pressed(input, SDL_SCANCODE_F4)) {
@@ -336,14 +695,18 @@ SDL_bool platform_update_and_render(Platform_State* platform, Platform_Game_Stat
 		return false;
 	}
 
+	if (platform->input_recording) {
+		record_input(platform->input_recording, input, dt, get_game_checksum(game));
+	}
+
 	poll_input(input); // Clear held and released states
 
-	SDL_SetRenderTarget(renderer, world_buffer);
+	platform_set_render_target(world_buffer);
 	draw_game_world(game);
-	SDL_SetRenderTarget(renderer, 0);
+	platform_set_render_target(0);
 
-	SDL_SetRenderDrawColor(renderer,0,0,0,0);
-	SDL_RenderClear(renderer);
+	platform_set_render_draw_color((RGBA_Color){0,0,0,0});
+	platform_render_clear();
 
 	SDL_GetWindowSize(window, &platform->screen.x, &platform->screen.y);
 
@@ -362,18 +725,32 @@ SDL_bool platform_update_and_render(Platform_State* platform, Platform_Game_Stat
 		world_rect.w, world_rect.h,
 	};
 	
-	SDL_RenderCopy(renderer, world_buffer, 0, &world_draw_rect);
+	Rectangle world_dst_rect = {world_draw_rect.x, world_draw_rect.y, world_draw_rect.w, world_draw_rect.h};
+	platform_render_copy(world_buffer, 0, &world_dst_rect, 0, 0, 0);
+	platform_flush_render_queue();
 	SDL_RenderSetClipRect(renderer, &world_draw_rect);
 	draw_game_ui(game);
+	platform_flush_render_queue();
 	SDL_RenderSetClipRect(renderer, 0);
+	render_queue.stats.sdl_calls += 2;
 
 	Uint64 frequency = SDL_GetPerformanceFrequency();
+	// Excludes waiting on the previous present, so vsync doesn't count against the budget.
+	// Recordings have to replay the same particles, so the budget is fixed while recording.
+	if (!platform->input_recording) {
+		double frame_time = (double)(SDL_GetPerformanceCounter() - frame_start) / (double)frequency * 1000.0;
+		govern_particle_budget(game->particle_system, (float)frame_time, (float)platform->target_frame_time);
+	}
+
 	double time_elapsed = (double)(SDL_GetPerformanceCounter() - platform->current_count) / (double)frequency * 1000.0;
 	precise_delay(platform->target_frame_time - time_elapsed);
 
 	platform->last_count = platform->current_count;
 	platform->current_count = SDL_GetPerformanceCounter();
+	platform_flush_render_queue();
 	SDL_RenderPresent(renderer);
+	end_render_stats_frame();
+	end_particle_stats_frame(game->particle_system);
 	
 	return true;
 }
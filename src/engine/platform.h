@@ -3,20 +3,40 @@
 
 #include "types.h"
 #include "input.h"
+#include "jobs.h"
+#include "replay.h"
+
+typedef struct Render_Stats {
+	Uint32 commands; // platform_render_* draws and state changes
+	Uint32 sdl_calls; // SDL render calls made for them
+	Uint32 batches; // Deferred batches flushed
+} Render_Stats;
 
 typedef struct Platform_State {
 	const char* title;
 	iVector2 screen, world;
 	double target_fps, target_frame_time;
 	Uint64 last_count, current_count;
+
+	Input_Replay* input_recording; // Records each frame's input passed to update_game if set
+
+	SDL_bool deferred_rendering; // Queue draws into batches instead of calling SDL for each one
+	int worker_count; // Job pool threads besides the main thread, or JOB_POOL_AUTO
+	Job_Pool* jobs; // Created by platform_init
 } Platform_State;
 
 void			platform_init				(Platform_State* platform);
+void			platform_init_headless			(Platform_State* platform);
 
 SDL_bool		platform_update_and_render		(Platform_State* platform,
 								 Platform_Game_State* game,
 								 Game_Input* input);
 
+void			platform_set_deferred_rendering		(SDL_bool deferred);
+SDL_bool		platform_get_deferred_rendering		(void);
+int			platform_flush_render_queue		(void);
+Render_Stats		platform_get_render_stats		(void);
+
 iVector2		platform_get_window_size		(void);
 int			platform_toggle_fullscreen		(void);
 int			platform_set_render_target		(SDL_Texture *texture);
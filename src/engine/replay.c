@@ -0,0 +1,181 @@
+#include "SDL_rwops.h"
+#include "replay.h"
+
+#define INPUT_REPLAY_MAGIC 0x50524453 // "SDRP"
+#define INPUT_REPLAY_VERSION 1
+
+// Changes are keyed by a single id: keys, then controller buttons, then controller axes
+#define INPUT_REPLAY_BUTTON_ID(button) (SDL_NUM_SCANCODES + (button))
+#define INPUT_REPLAY_AXIS_ID(axis) (SDL_NUM_SCANCODES + SDL_CONTROLLER_BUTTON_MAX + (axis))
+#define INPUT_REPLAY_ID_COUNT INPUT_REPLAY_AXIS_ID(SDL_CONTROLLER_AXIS_MAX)
+
+typedef enum Input_Replay_Tick_Flags {
+	INPUT_REPLAY_TICK_DT = (1<<0), // dt differs from the previous tick
+} Input_Replay_Tick_Flags;
+
+struct Input_Replay {
+	SDL_RWops* file;
+	SDL_bool recording;
+	Uint32 seed;
+
+	Game_Input last_input;
+	float last_dt;
+};
+
+static inline Uint32 float_bits(float f) {
+	Uint32 result;
+	SDL_memcpy(&result, &f, sizeof(result));
+	return result;
+}
+
+static inline float bits_float(Uint32 bits) {
+	float result;
+	SDL_memcpy(&result, &bits, sizeof(result));
+	return result;
+}
+
+Input_Replay* start_input_recording(const char* file_name, Uint32 seed) {
+	Input_Replay* result = 0;
+
+	SDL_RWops* file = SDL_RWFromFile(file_name, "wb");
+	if (file == NULL) {
+		SDL_Log("start_input_recording(): %s", SDL_GetError());
+		return result;
+	}
+
+	SDL_WriteLE32(file, INPUT_REPLAY_MAGIC);
+	SDL_WriteLE16(file, INPUT_REPLAY_VERSION);
+	SDL_WriteLE32(file, seed);
+
+	result = SDL_calloc(1, sizeof(Input_Replay));
+	result->file = file;
+	result->recording = true;
+	result->seed = seed;
+
+	return result;
+}
+
+Input_Replay* start_input_replay(const char* file_name) {
+	Input_Replay* result = 0;
+
+	SDL_RWops* file = SDL_RWFromFile(file_name, "rb");
+	if (file == NULL) {
+		SDL_Log("start_input_replay(): %s", SDL_GetError());
+		return result;
+	}
+
+	Uint32 magic = SDL_ReadLE32(file);
+	Uint16 version = SDL_ReadLE16(file);
+	if (magic != INPUT_REPLAY_MAGIC || version != INPUT_REPLAY_VERSION) {
+		SDL_Log("start_input_replay(): %s is not a version %d input recording", file_name, INPUT_REPLAY_VERSION);
+		SDL_RWclose(file);
+		return result;
+	}
+
+	result = SDL_calloc(1, sizeof(Input_Replay));
+	result->file = file;
+	result->seed = SDL_ReadLE32(file);
+
+	return result;
+}
+
+void close_input_replay(Input_Replay* replay) {
+	if (replay) {
+		SDL_RWclose(replay->file);
+		SDL_free(replay);
+	}
+}
+
+Uint32 get_input_replay_seed(Input_Replay* replay) {
+	return replay->seed;
+}
+
+static inline Game_Input_State* get_input_replay_state(Game_Input* input, int id) {
+	Game_Input_State* result = 0;
+
+	if (id < SDL_NUM_SCANCODES) {
+		result = input->keys + id;
+	} else if (id < INPUT_REPLAY_AXIS_ID(0)) {
+		result = input->controller.buttons + (id - INPUT_REPLAY_BUTTON_ID(0));
+	}
+
+	return result;
+}
+
+void record_input(Input_Replay* replay, Game_Input* input, float dt, Uint32 checksum) {
+	if (!replay || !replay->recording) return;
+
+	Uint16 changes[INPUT_REPLAY_ID_COUNT];
+	Uint16 change_count = 0;
+	for (int id = 0; id < INPUT_REPLAY_AXIS_ID(0); id++) {
+		if (*get_input_replay_state(input, id) != *get_input_replay_state(&replay->last_input, id)) {
+			changes[change_count++] = id;
+		}
+	}
+	for (int axis = 0; axis < SDL_CONTROLLER_AXIS_MAX; axis++) {
+		if (float_bits(input->controller.axes[axis]) != float_bits(replay->last_input.controller.axes[axis])) {
+			changes[change_count++] = INPUT_REPLAY_AXIS_ID(axis);
+		}
+	}
+
+	Uint8 flags = 0;
+	if (float_bits(dt) != float_bits(replay->last_dt)) {
+		flags |= INPUT_REPLAY_TICK_DT;
+	}
+
+	SDL_WriteU8(replay->file, flags);
+	if (flags & INPUT_REPLAY_TICK_DT) {
+		SDL_WriteLE32(replay->file, float_bits(dt));
+	}
+
+	SDL_WriteLE16(replay->file, change_count);
+	for (int i = 0; i < change_count; i++) {
+		Uint16 id = changes[i];
+		SDL_WriteLE16(replay->file, id);
+
+		if (id < INPUT_REPLAY_AXIS_ID(0)) {
+			SDL_WriteU8(replay->file, (Uint8)*get_input_replay_state(input, id));
+		} else {
+			SDL_WriteLE32(replay->file, float_bits(input->controller.axes[id - INPUT_REPLAY_AXIS_ID(0)]));
+		}
+	}
+
+	SDL_WriteLE32(replay->file, checksum);
+
+	replay->last_input = *input;
+	replay->last_dt = dt;
+}
+
+// Overwrites input with the next recorded tick. Returns false at the end of the recording.
+SDL_bool replay_input(Input_Replay* replay, Game_Input* input, float* dt, Uint32* checksum) {
+	SDL_bool result = false;
+	if (!replay || replay->recording) return result;
+
+	Uint8 flags;
+	if (SDL_RWread(replay->file, &flags, sizeof(flags), 1) != 1) return result;
+
+	if (flags & INPUT_REPLAY_TICK_DT) {
+		replay->last_dt = bits_float(SDL_ReadLE32(replay->file));
+	}
+
+	Uint16 change_count = SDL_ReadLE16(replay->file);
+	for (int i = 0; i < change_count; i++) {
+		Uint16 id = SDL_ReadLE16(replay->file);
+
+		if (id < INPUT_REPLAY_AXIS_ID(0)) {
+			*get_input_replay_state(&replay->last_input, id) = (Game_Input_State)SDL_ReadU8(replay->file);
+		} else if (id < INPUT_REPLAY_ID_COUNT) {
+			replay->last_input.controller.axes[id - INPUT_REPLAY_AXIS_ID(0)] = bits_float(SDL_ReadLE32(replay->file));
+		} else {
+			SDL_Log("replay_input(): Invalid input id %d", id);
+			return result;
+		}
+	}
+
+	*checksum = SDL_ReadLE32(replay->file);
+	*input = replay->last_input;
+	*dt = replay->last_dt;
+	result = true;
+
+	return result;
+}
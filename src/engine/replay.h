@@ -0,0 +1,21 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include "types.h"
+#include "input.h"
+
+// Per-tick input recordings for reproducing a session exactly.
+// Each tick stores the changes to Game_Input since the previous tick, the tick's dt
+// and a checksum of the game state after the update, so replays can detect divergence.
+typedef struct Input_Replay Input_Replay;
+
+Input_Replay*	start_input_recording		(const char* file_name, Uint32 seed);
+Input_Replay*	start_input_replay		(const char* file_name);
+void		close_input_replay		(Input_Replay* replay);
+
+Uint32		get_input_replay_seed		(Input_Replay* replay);
+
+void		record_input			(Input_Replay* replay, Game_Input* input, float dt, Uint32 checksum);
+SDL_bool	replay_input			(Input_Replay* replay, Game_Input* input, float* dt, Uint32* checksum);
+
+#endif
@@ -0,0 +1,152 @@
+#include "spatial_grid.h"
+
+typedef struct Spatial_Grid_Entry {
+	Uint32 id;
+	Sint32 next;
+} Spatial_Grid_Entry;
+
+struct Spatial_Grid {
+	float cell_size;
+	Rectangle bounds;
+	int columns, rows;
+
+	Sint32* cells; // Index of the first entry in each cell, -1 if empty
+	int cell_capacity;
+
+	Spatial_Grid_Entry* entries;
+	int entry_count, entry_capacity;
+
+	// Per-id stamps used to deduplicate ids that span multiple cells
+	Uint32* stamps;
+	Uint32 stamp, stamp_capacity;
+};
+
+Spatial_Grid* new_spatial_grid(float cell_size) {
+	Spatial_Grid* result = SDL_calloc(1, sizeof(Spatial_Grid));
+	result->cell_size = cell_size;
+
+	return result;
+}
+
+void free_spatial_grid(Spatial_Grid* grid) {
+	if (grid) {
+		SDL_free(grid->cells);
+		SDL_free(grid->entries);
+		SDL_free(grid->stamps);
+		SDL_free(grid);
+	}
+}
+
+void reset_spatial_grid(Spatial_Grid* grid, Rectangle bounds) {
+	grid->bounds = bounds;
+	grid->columns = SDL_max(1, (int)SDL_ceilf(bounds.w / grid->cell_size));
+	grid->rows = SDL_max(1, (int)SDL_ceilf(bounds.h / grid->cell_size));
+
+	int cell_count = grid->columns * grid->rows;
+	if (cell_count > grid->cell_capacity) {
+		grid->cells = SDL_realloc(grid->cells, sizeof(Sint32) * cell_count);
+		grid->cell_capacity = cell_count;
+	}
+
+	for (int i = 0; i < cell_count; i++) {
+		grid->cells[i] = -1;
+	}
+	grid->entry_count = 0;
+}
+
+static inline int wrap_cell(int cell, int count) {
+	cell %= count;
+	if (cell < 0) cell += count;
+
+	return cell;
+}
+
+// Get the unwrapped range of cells covered by [min, max] along one axis.
+// Ranges covering the whole axis are clamped so no cell is visited twice.
+static inline void get_cell_span(float min, float max, float origin, float cell_size, int count, int* first, int* last) {
+	*first = (int)SDL_floorf((min - origin) / cell_size);
+	*last  = (int)SDL_floorf((max - origin) / cell_size);
+
+	if (*last - *first + 1 >= count) {
+		*first = 0;
+		*last = count - 1;
+	}
+}
+
+void spatial_grid_insert(Spatial_Grid* grid, Uint32 id, Vector2 position, float radius) {
+	if (id >= grid->stamp_capacity) {
+		Uint32 new_capacity = SDL_max(id + 1, grid->stamp_capacity * 2);
+		grid->stamps = SDL_realloc(grid->stamps, sizeof(Uint32) * new_capacity);
+		SDL_memset(grid->stamps + grid->stamp_capacity, 0, sizeof(Uint32) * (new_capacity - grid->stamp_capacity));
+		grid->stamp_capacity = new_capacity;
+	}
+
+	int x0, x1, y0, y1;
+	get_cell_span(position.x - radius, position.x + radius, grid->bounds.x, grid->cell_size, grid->columns, &x0, &x1);
+	get_cell_span(position.y - radius, position.y + radius, grid->bounds.y, grid->cell_size, grid->rows, &y0, &y1);
+
+	for (int y = y0; y <= y1; y++) {
+		int row = wrap_cell(y, grid->rows) * grid->columns;
+
+		for (int x = x0; x <= x1; x++) {
+			if (grid->entry_count == grid->entry_capacity) {
+				grid->entry_capacity = SDL_max(64, grid->entry_capacity * 2);
+				grid->entries = SDL_realloc(grid->entries, sizeof(Spatial_Grid_Entry) * grid->entry_capacity);
+			}
+
+			Sint32* cell = grid->cells + row + wrap_cell(x, grid->columns);
+			grid->entries[grid->entry_count] = (Spatial_Grid_Entry) {
+				.id = id,
+				.next = *cell,
+			};
+			*cell = grid->entry_count++;
+		}
+	}
+}
+
+static int compare_ids(const void* a, const void* b) {
+	Uint32 id_a = *(const Uint32*)a, id_b = *(const Uint32*)b;
+	return (id_a > id_b) - (id_a < id_b);
+}
+
+// Writes unique ids from every cell overlapped by the query circle's bounding box to results.
+// Pass sorted to get them in ascending order, so callers visit candidates in the same order
+// as a linear scan would. Otherwise they come in cell order.
+int spatial_grid_query(Spatial_Grid* grid, Vector2 position, float radius, Uint32* results, int max_results, SDL_bool sorted) {
+	int result = 0;
+
+	if (grid->entry_count == 0) return result;
+
+	grid->stamp++;
+	if (grid->stamp == 0) {
+		SDL_memset(grid->stamps, 0, sizeof(Uint32) * grid->stamp_capacity);
+		grid->stamp = 1;
+	}
+
+	int x0, x1, y0, y1;
+	get_cell_span(position.x - radius, position.x + radius, grid->bounds.x, grid->cell_size, grid->columns, &x0, &x1);
+	get_cell_span(position.y - radius, position.y + radius, grid->bounds.y, grid->cell_size, grid->rows, &y0, &y1);
+
+	for (int y = y0; y <= y1; y++) {
+		int row = wrap_cell(y, grid->rows) * grid->columns;
+
+		for (int x = x0; x <= x1; x++) {
+			Sint32 entry_index = grid->cells[row + wrap_cell(x, grid->columns)];
+
+			while (entry_index >= 0) {
+				Spatial_Grid_Entry* entry = grid->entries + entry_index;
+				if (grid->stamps[entry->id] != grid->stamp && result < max_results) {
+					grid->stamps[entry->id] = grid->stamp;
+					results[result++] = entry->id;
+				}
+				entry_index = entry->next;
+			}
+		}
+	}
+
+	if (sorted && result > 1) {
+		SDL_qsort(results, result, sizeof(Uint32), compare_ids);
+	}
+
+	return result;
+}
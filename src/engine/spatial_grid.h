@@ -0,0 +1,18 @@
+#ifndef SPATIAL_GRID_H
+#define SPATIAL_GRID_H
+
+#include "types.h"
+
+// Uniform grid over a toroidal world. Ids are binned by bounding circle,
+// so queries return a conservative superset of possible overlaps.
+typedef struct Spatial_Grid Spatial_Grid;
+
+Spatial_Grid*	new_spatial_grid		(float cell_size);
+void		free_spatial_grid		(Spatial_Grid* grid);
+void		reset_spatial_grid		(Spatial_Grid* grid, Rectangle bounds);
+
+void		spatial_grid_insert		(Spatial_Grid* grid, Uint32 id, Vector2 position, float radius);
+int		spatial_grid_query		(Spatial_Grid* grid, Vector2 position, float radius,
+						 Uint32* results, int max_results, SDL_bool sorted);
+
+#endif
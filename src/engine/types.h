@@ -53,10 +53,17 @@ typedef struct Rectangle {
 	float h;
 } Rectangle;
 
+// Random number generator state. See random_u32() in math.h
+typedef struct Random_Series {
+	Uint64 state;
+	Uint64 increment; // Selects the stream, always odd
+} Random_Series;
+
 #define MAX_POLY2D_VERTS 8
 typedef struct Poly2D {
 	Vector2 vertices[MAX_POLY2D_VERTS];
 	Uint32 vert_count;
+	float radius; // Distance from the origin to the farthest vertex, 0 if unknown
 } Poly2D;
 
 typedef enum Game_Shape_Types {
@@ -76,6 +83,19 @@ typedef struct Game_Shape {
 	};
 } Game_Shape;
 
+// A shape resolved to world space once so it can be tested against many others.
+// Circles stay circles under uniform scale and unrotated rects stay rects,
+// everything else becomes a polygon with precomputed edge normals.
+// Vertices and bounds are relative to position, so moving a collider only changes position.
+typedef struct Collider {
+	Game_Shape_Types type; // SHAPE_TYPE_UNDEFINED if the shape can't collide
+	Vector2 position;
+	float radius; // Circle radius or bounding radius of the polygon
+	Rectangle bounds;
+	Poly2D polygon;
+	Vector2 normals[MAX_POLY2D_VERTS];
+} Collider;
+
 typedef struct Game_Sprite {
 	char* texture_name;
 	Rectangle src_rect;
@@ -87,29 +107,49 @@ typedef struct Mix_Music_Node 	{ char* name; Mix_Music* data; 	 struct Mix_Music
 typedef struct Mix_Chunk_Node 	{ char* name; Mix_Chunk* data; 	 struct Mix_Chunk_Node* next; 	} Mix_Chunk_Node;
 typedef struct SDL_Texture_Node { char* name; SDL_Texture* data; struct SDL_Texture_Node* next; } SDL_Texture_Node;
 
+// Where a texture packed by assets_build_texture_atlas ended up
+typedef struct Atlas_Region { SDL_Texture* page; Rectangle rect; } Atlas_Region;
+typedef struct Atlas_Region_Node { char* name; Atlas_Region* data; struct Atlas_Region_Node* next; } Atlas_Region_Node;
+
 #include "external/stb_truetype.h"
+// Glyphs resolved from a font's distance field for one text size
+typedef struct STBTTF_Font_Page {
+	stbtt_packedchar* chars;
+	SDL_Texture* atlas;
+	int texture_w, texture_h; // Pages are trimmed to the height their glyphs need
+	float size;
+} STBTTF_Font_Page;
+
+#define STBTTF_FONT_MAX_PAGES 16
+
 typedef struct STBTTF_Font {
 	stbtt_fontinfo* info;
 	stbtt_packedchar* chars;
-	SDL_Texture* atlas;
+	SDL_Texture* atlas; // 0 in SDF mode
 	int texture_size;
 	float size;
 	float scale;
 	int ascent;
 	int baseline;
+
+	// SDF mode: glyph distance fields baked once at size, with chars locating them in sdf.
+	// Pages for the sizes text is drawn at are resolved from it as needed.
+	unsigned char* sdf;
+	STBTTF_Font_Page* pages[STBTTF_FONT_MAX_PAGES];
 } STBTTF_Font;
 
 typedef struct Game_Assets Game_Assets;
 
+// Per-particle data that is only read when drawing and colliding.
+// Positions, velocities and timers are stored in separate lanes in Particle_System.
 typedef struct Particle {
-	Transform2D_Union;
-	Vec2_Union(velocity, vx, vy);
-	float mass;
-	float timer;
-
-	Game_Sprite sprite;
-	Game_Shape shape;
+	float angle;
 	RGBA_Color color;
+	SDL_Texture* texture; // Resolved when spawned, 0 for shape particles
+	Rectangle src_rect;
+	Vector2 scale; // Applied to the shape template along with the timer's scale
+	Uint16 shape_template; // Index into the system's shape templates
+	Uint8 shape_type; // Game_Shape_Types
 } Particle;
 
 typedef struct Particle_Emitter {
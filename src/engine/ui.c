@@ -75,17 +75,23 @@ void draw_ui_element(ui_element* e, STBTTF_Font* font) {
 		case UI_TYPE_TEXTURE: {
 			SDL_Texture* texture = e->texture.texture;
 			if (texture) {
+				Rectangle* src = (e->texture.src.w && e->texture.src.h) ? &e->texture.src : 0;
 				Rectangle dest = e->texture.dest;
 				if (dest.w == 0 && dest.h == 0) {
-					int w, h;
-					SDL_QueryTexture(texture, NULL, NULL, &w, &h);
-					dest.w = w;
-					dest.h = h;
+					if (src) {
+						dest.w = src->w;
+						dest.h = src->h;
+					} else {
+						int w, h;
+						SDL_QueryTexture(texture, NULL, NULL, &w, &h);
+						dest.w = w;
+						dest.h = h;
+					}
 				}
 				Vector2 pos = {e->pos.x-dest.w/2.0f, e->pos.y-dest.h/2.0f};
 				dest = translate_rect(dest, pos);
 
-				platform_render_copy(texture, 0, &dest, e->angle, 0, 0);
+				platform_render_copy(texture, src, &dest, e->angle, 0, 0);
 			}
 		} break;
 
@@ -140,7 +146,10 @@ void scale_ui_element(ui_element* e, float scale) {
 
 		case UI_TYPE_TEXTURE: {
 			Rectangle* dest = &(e->texture.dest);
-			if ( (dest->x+dest->y+dest->w+dest->h) == 0 ) {
+			if ( (dest->x+dest->y+dest->w+dest->h) == 0 && e->texture.src.w && e->texture.src.h) {
+				e->texture.dest.w = e->texture.src.w;
+				e->texture.dest.h = e->texture.src.h;
+			} else if ( (dest->x+dest->y+dest->w+dest->h) == 0 ) {
 				int width, height;
 				SDL_QueryTexture(e->texture.texture, 0, 0, &width, &height);
 
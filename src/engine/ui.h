@@ -26,7 +26,7 @@ struct ui_element {
 	union {
 		Poly2D polygon;
 		Rectangle rect;
-		struct {Rectangle dest; SDL_Texture* texture; } texture;
+		struct {Rectangle dest; SDL_Texture* texture; Rectangle src; } texture; // Zero src for the whole texture
 		struct {int size; char* str; char* align; } text;
 	};
 
@@ -1,6 +1,7 @@
 #include "../engine/math.h"
 #include "../engine/assets.h"
 #include "../engine/graphics.h"
+#include "../engine/spatial_grid.h"
 
 #include "score.h"
 #include "entities.h"
@@ -9,21 +10,95 @@
 #define ENTITY_WARP_DELAY 26.0f
 #define ENTITY_WARP_RADIUS 20
 #define ENEMY_EXPLOSION_RADIUS 100.0f
+#define ENTITY_EXPLOSION_PIECES 6
 #define ITEM_ACCUMULATE_RATE 1
 #define PHYSICS_FRICTION 0.02f
 #define WAVE_ESCALATION_RATE 4
 
-#define MAX_ENTITIES 256
-struct Entity_System {
-	Entity entities[MAX_ENTITIES];
-	Uint32 num_entities;
+#define ENTITY_HANDLE_INDEX_BITS 20
+#define ENTITY_HANDLE_INDEX_MASK ((1u << ENTITY_HANDLE_INDEX_BITS) - 1)
+#define ENTITY_HANDLE_GENERATION_MASK ((1u << (32 - ENTITY_HANDLE_INDEX_BITS)) - 1)
+
+#define ENTITY_SPAWN_RANDOM_STREAM 2
+#define ENTITY_AI_RANDOM_STREAM 3
+
+#define ENTITY_GRID_CELL_SIZE 64.0f
+#define ENTITY_GRID_PADDING 1.0f
+
+// Grow the pool at the start of a tick once it is this full,
+// so entities spawned during the tick rarely find it exhausted
+#define ENTITY_POOL_GROW_THRESHOLD 0.75f
 
-	Uint32 next;
+struct Entity_System {
+	// Hot data, read every tick by integration, wrapping and collision
+	Vector2* positions;
+	Vector2* velocities;
+	Uint32* flags; // Free slots store the id of the next free slot here
+	Uint8* states;
+
+	// Cold render and AI data
+	Entity* entities;
+	Uint16* generations; // Incremented each time a slot is freed
+	Uint32 num_entities; // Highest slot ever allocated since the last reset
+	Uint32 capacity;
+
+	Uint32 free_list; // Id of the most recently freed slot, 0 if none
+
+	// Growing moves every array, so it is deferred while update_entities holds entity pointers
+	SDL_bool locked;
+	SDL_bool grow_pending;
+
+	// Collision broadphase and world-space colliders, rebuilt once per tick by update_entities
+	Spatial_Grid* grid;
+	Uint32* candidates;
+	Collider* colliders;
+
+	// Separate series so AI decisions don't shift spawn positions and types, and vice versa
+	Random_Series spawn_random;
+	Random_Series ai_random;
 };
 
+static inline Uint32 get_entity_index(Entity_System* es, Entity* entity) {
+	return (Uint32)(entity - es->entities);
+}
+
+Vector2* entity_position(Entity_System* es, Entity* entity) {
+	return es->positions + get_entity_index(es, entity);
+}
+
+Vector2* entity_velocity(Entity_System* es, Entity* entity) {
+	return es->velocities + get_entity_index(es, entity);
+}
+
+Entity_States get_entity_state(Entity_System* es, Entity* entity) {
+	return es->states[get_entity_index(es, entity)];
+}
+
+void set_entity_state(Entity_System* es, Entity* entity, Entity_States state) {
+	es->states[get_entity_index(es, entity)] = state;
+}
+
+Uint32 get_entity_flags(Entity_System* es, Entity* entity) {
+	return es->flags[get_entity_index(es, entity)];
+}
+
+void set_entity_flags(Entity_System* es, Entity* entity, Uint32 flags) {
+	es->flags[get_entity_index(es, entity)] = flags;
+}
+
+Transform2D get_entity_transform(Entity_System* es, Entity* entity) {
+	Transform2D result = {
+		.position = es->positions[get_entity_index(es, entity)],
+		.scale = entity->scale,
+		.angle = entity->angle,
+	};
+
+	return result;
+}
+
 static inline Entity* get_enemy_target(Game_State* game) {
 	Entity* target = get_entity(game->entities, game->player);
-	if (target != NULL && target->state == ENTITY_STATE_ACTIVE) {
+	if (target != NULL && get_entity_state(game->entities, target) == ENTITY_STATE_ACTIVE) {
 		return target;	
 	}
 
@@ -39,53 +114,123 @@ static inline Entity* get_enemy_target(Game_State* game) {
 #include "entities/turret.c"
 #include "entities/grappler.c"
 
-Entity_System* create_entity_system() {
+static void grow_entity_system(Entity_System* es, Uint32 capacity) {
+	if (capacity <= es->capacity) { return; }
+
+	es->positions	= SDL_realloc(es->positions,	sizeof(Vector2) * capacity);
+	es->velocities	= SDL_realloc(es->velocities,	sizeof(Vector2) * capacity);
+	es->flags	= SDL_realloc(es->flags,	sizeof(Uint32) * capacity);
+	es->states	= SDL_realloc(es->states,	sizeof(Uint8) * capacity);
+	es->entities	= SDL_realloc(es->entities,	sizeof(Entity) * capacity);
+	es->generations	= SDL_realloc(es->generations,	sizeof(Uint16) * capacity);
+	SDL_memset(es->generations + es->capacity, 0, sizeof(Uint16) * (capacity - es->capacity));
+	es->candidates	= SDL_realloc(es->candidates,	sizeof(Uint32) * capacity);
+	es->colliders	= SDL_realloc(es->colliders,	sizeof(Collider) * capacity);
+
+	es->capacity = capacity;
+	es->grow_pending = false;
+}
+
+Entity_System* create_entity_system(Uint32 capacity, Uint64 seed) {
 	Entity_System* result = calloc(1, sizeof(Entity_System));
+	result->grid = new_spatial_grid(ENTITY_GRID_CELL_SIZE);
+	seed_random_series(&result->spawn_random, seed, ENTITY_SPAWN_RANDOM_STREAM);
+	seed_random_series(&result->ai_random, seed, ENTITY_AI_RANDOM_STREAM);
+	grow_entity_system(result, SDL_clamp(capacity, 1, ENTITY_HANDLE_INDEX_MASK));
 
 	return result;
 }
 
 void reset_entity_system(Entity_System* es) {
 	es->num_entities = 0;
-	es->next = 0;
+	es->free_list = 0;
+}
+
+// Number of slots holding a live entity
+Uint32 get_entity_count(Entity_System* es) {
+	Uint32 result = 0;
+	for (int i = 0; i < es->num_entities; i++) {
+		result += (es->states[i] != ENTITY_STATE_UNDEFINED);
+	}
+
+	return result;
+}
+
+Uint32 hash_entity_system(Entity_System* es, Uint32 hash) {
+	for (int i = 0; i < es->num_entities; i++) {
+		if (es->states[i] == ENTITY_STATE_UNDEFINED) { continue; }
+
+		hash = hash_bytes(hash, es->positions + i, sizeof(Vector2));
+		hash = hash_bytes(hash, es->velocities + i, sizeof(Vector2));
+		hash = hash_bytes(hash, es->states + i, sizeof(Uint8));
+		hash = hash_bytes(hash, &es->entities[i].angle, sizeof(float));
+		hash = hash_bytes(hash, &es->entities[i].type, sizeof(Uint8));
+	}
+	hash = hash_bytes(hash, &es->spawn_random.state, sizeof(es->spawn_random.state));
+	hash = hash_bytes(hash, &es->ai_random.state, sizeof(es->ai_random.state));
+
+	return hash;
 }
 
 void despawn_entities(Entity_System* es) {
-	for (Entity* e = es->entities; e != es->entities+es->num_entities; e++) {
-		if (e->state > ENTITY_STATE_UNDEFINED && e->state < ENTITY_STATE_COUNT) {
-			e->state = ENTITY_STATE_DESPAWNING;
+	for (int i = 0; i < es->num_entities; i++) {
+		Entity* e = es->entities + i;
+		if (es->states[i] > ENTITY_STATE_UNDEFINED && es->states[i] < ENTITY_STATE_COUNT) {
+			es->states[i] = ENTITY_STATE_DESPAWNING;
 			lerp_timer_start(&e->timer, 0, ENTITY_WARP_DELAY, -1);
 			lerp_timer_set_t(&e->timer, (e->scale.x+e->scale.y)/2.0f);
 		}
 	}
 }
 
-// Get valid, active entity or null pointer
-Entity* get_entity(Entity_System* es, Uint32 entity_id) {
+// Get the live entity referred to by handle, or null if it has been removed
+Entity* get_entity(Entity_System* es, Entity_Handle handle) {
 	Entity* result = 0;
+	Uint32 index = handle & ENTITY_HANDLE_INDEX_MASK;
 
-	if (entity_id > 0 && entity_id <= MAX_ENTITIES) {
-		result = es->entities + (entity_id-1);
+	if (	index > 0 && index <= es->num_entities 
+		&& es->generations[index-1] == (handle >> ENTITY_HANDLE_INDEX_BITS)
+		&& es->states[index-1] != ENTITY_STATE_UNDEFINED
+	) {
+		result = es->entities + (index-1);
 	}
 
 	return result;
 }
 
-Uint32 get_new_entity(Entity_System* es) {
+static inline Entity_Handle make_entity_handle(Entity_System* es, Uint32 index) {
+	return index | ((Entity_Handle)es->generations[index-1] << ENTITY_HANDLE_INDEX_BITS);
+}
+
+Entity_Handle get_entity_handle(Entity_System* es, Entity* entity) {
+	return make_entity_handle(es, get_entity_index(es, entity) + 1);
+}
+
+// Pointers returned by get_entity are invalidated when the pool grows,
+// which only happens outside of update_entities
+Entity_Handle get_new_entity(Entity_System* es) {
 	Uint32 result = 0;
 
-	if (es->next) {
-		result = es->next;
-		es->next = 0;
-		for (int i=result; i < es->num_entities; i++) {
-			if (es->entities[i].state == ENTITY_STATE_UNDEFINED) {
-				es->next = (i+1);
-				break;
+	if (es->free_list) {
+		result = es->free_list;
+		es->free_list = es->flags[result-1];
+	} else {
+		if (es->num_entities == es->capacity) {
+			if (es->locked) {
+				es->grow_pending = true;
+			} else {
+				grow_entity_system(es, SDL_min(es->capacity * 2, ENTITY_HANDLE_INDEX_MASK));
 			}
 		}
-	} else if (es->num_entities < MAX_ENTITIES) {
-		es->num_entities++;
-		result = es->num_entities;
+
+		if (es->num_entities < es->capacity) {
+			es->num_entities++;
+			result = es->num_entities;
+		}
+	}
+
+	if (result) {
+		result = make_entity_handle(es, result);
 	}
 
 	return result;
@@ -94,12 +239,12 @@ Uint32 get_new_entity(Entity_System* es) {
 Uint32 remove_entity(Entity_System* es, Uint32 id) {
 	Uint32 result = 0;
 
-	if (id <= es->num_entities) {
-		es->entities[id-1].state = ENTITY_STATE_UNDEFINED;
+	if (id > 0 && id <= es->num_entities && es->states[id-1] != ENTITY_STATE_UNDEFINED) {
+		es->states[id-1] = ENTITY_STATE_UNDEFINED;
 		es->entities[id-1].type = ENTITY_TYPE_UNDEFINED;
-		if (!es->next || id < es->next) {
-			es->next = id;
-		}
+		es->generations[id-1] = (es->generations[id-1] + 1) & ENTITY_HANDLE_GENERATION_MASK;
+		es->flags[id-1] = es->free_list;
+		es->free_list = id;
 	}
 
 	return result;
@@ -122,20 +267,20 @@ void force_circle(Entity_System* es, float x, float y, float radius, float force
 
 	Vector2 overlap;
 	for (int i = 1; i <= es->num_entities; i++) {
-		Entity* entity = get_entity(es, i);
 		if (
-			entity == NULL
-			|| entity->flags & (ENTITY_FLAG_COLLISION_TRIGGER|ENTITY_FLAG_COLLISION_DISABLED)
+			es->states[i-1] == ENTITY_STATE_UNDEFINED
+			|| es->flags[i-1] & (ENTITY_FLAG_COLLISION_TRIGGER|ENTITY_FLAG_COLLISION_DISABLED)
 		) { 
 			continue;
 		}
+		Entity* entity = es->entities + (i-1);
 
-		if (check_shape_collision(force_transform, force_shape, entity->transform, entity->shape, &overlap)) {
-			Vector2 impulse = subtract_vector2(entity->position, (Vector2){x,y});
+		if (check_shape_collision(force_transform, force_shape, get_entity_transform(es, entity), entity->shape, &overlap)) {
+			Vector2 impulse = subtract_vector2(es->positions[i-1], (Vector2){x,y});
 					impulse = normalize_vector2(impulse);
 					impulse = scale_vector2(impulse, force);
 				
-			entity->velocity = add_vector2(entity->velocity, impulse);
+			es->velocities[i-1] = add_vector2(es->velocities[i-1], impulse);
 		}
 	}
 }
@@ -154,27 +299,40 @@ static inline float get_entity_score_value(Entity_Types type) {
 	return result;
 }
 
+Random_Series* get_spawn_random(Entity_System* es) {
+	return &es->spawn_random;
+}
+
 Vector2 get_clear_spawn(Entity_System* es, float radius, SDL_Rect boundary) {
-	Vector2 result = {
-		.x = (boundary.x + radius) + randomf() * (boundary.x + boundary.w - radius),
-		.y = (boundary.y + radius) + randomf() * (boundary.y + boundary.h - radius),
-	};
+	// Initializer evaluation order is unspecified, so draw x and y in separate statements
+	Vector2 result;
+	result.x = (boundary.x + radius) + random_float(&es->spawn_random) * (boundary.x + boundary.w - radius);
+	result.y = (boundary.y + radius) + random_float(&es->spawn_random) * (boundary.y + boundary.h - radius);
 
 	Game_Shape spawn_area = {
 		.type = SHAPE_TYPE_CIRCLE,
 		.radius = radius,
 	};
 
+	Collider spawn_collider = get_collider((Transform2D){.position=result, .scale={1,1}}, spawn_area);
+
 	Vector2 overlap = {0};
-	Entity* entity;
 	for (int i = 1; i <= es->num_entities; i++) {
-		entity = get_entity(es, i);
-		if (entity == NULL) continue;
+		if (es->states[i-1] == ENTITY_STATE_UNDEFINED) continue;
+
+		// build_entity_grid already made colliders for active entities this tick and only velocities
+		// change after it, anything spawned since is marked undefined and gets its own
+		Collider* entity_collider = es->colliders + (i-1);
+		Collider built_collider;
+		if (es->states[i-1] != ENTITY_STATE_ACTIVE || entity_collider->type == SHAPE_TYPE_UNDEFINED) {
+			built_collider = get_collider(get_entity_transform(es, es->entities + (i-1)), es->entities[i-1].shape);
+			entity_collider = &built_collider;
+		}
 
-		Game_Shape entity_shape = scale_game_shape(entity->shape, entity->scale);
-		if (check_shape_collision((Transform2D){.position=result, .scale={1,1}}, spawn_area, entity->transform, entity_shape, &overlap)) {
+		if (check_collider_collision(&spawn_collider, entity_collider, &overlap)) {
 			result.x -= overlap.x;
 			result.y -= overlap.y;
+			spawn_collider.position = result;
 		}
 	}
 
@@ -195,65 +353,71 @@ static inline bool entity_is_item(Entity_Types type) {
 	);
 }
 
-Uint32 spawn_entity(Entity_System* es, Particle_System* ps, Entity_Types type, Vector2 position) {
+Entity_Handle spawn_entity(Entity_System* es, Particle_System* ps, Entity_Types type, Vector2 position) {
+	Entity_Handle handle = 0;
 	Uint32 result = 0;
-	Entity* entity;
+	Entity* entity = 0;
 
 	if (type > ENTITY_TYPE_UNDEFINED && type < ENTITY_TYPE_COUNT) {
-		result = get_new_entity(es);
-		entity  = get_entity(es, result);
+		handle = get_new_entity(es);
+		result = handle & ENTITY_HANDLE_INDEX_MASK;
 	}
-	if (entity == NULL) { return 0; }
+	if (result == 0) { return 0; }
+	entity = es->entities + (result-1);
 
 	*entity = (Entity) {
 		.type = type,
-		.position = position,
 		.scale = { 1.0f, 1.0f },
 		.shape.type = SHAPE_TYPE_CIRCLE,
 		.shape.radius = DEFAULT_ENTITY_RADIUS,
-		.state = ENTITY_STATE_SPAWNING,
 		.team = ENTITY_TEAM_ENEMY,
 	};
+	es->positions[result-1] = position;
+	es->velocities[result-1] = (Vector2){0};
+	es->states[result-1] = ENTITY_STATE_SPAWNING;
+	es->flags[result-1] = 0;
+	es->colliders[result-1].type = SHAPE_TYPE_UNDEFINED; // Not resolved until the next build_entity_grid
 	lerp_timer_start(&entity->timer, 0, ENTITY_WARP_DELAY, -1);
 
 	switch(type) {
 		case ENTITY_TYPE_DEMOSHIP: {
 			entity->timer = (Lerp_Timer){0};
 		}
-		case ENTITY_TYPE_PLAYER:	{ init_player(ps, entity); } break;
-		case ENTITY_TYPE_BULLET:	{ init_bullet(entity); } break;
-		case ENTITY_TYPE_MISSILE:	{ init_missile(ps, entity); } break;
-		case ENTITY_TYPE_LASER:		{ init_laser(entity); } break;
-		case ENTITY_TYPE_ENEMY_DRIFTER: { init_drifter(entity); } break;
-		case ENTITY_TYPE_ENEMY_UFO:	{ init_ufo(entity); } break;
-		case ENTITY_TYPE_ENEMY_TRACKER: { init_tracker(ps, entity); } break;
-		case ENTITY_TYPE_ENEMY_TURRET:	{ init_turret(entity); } break;
-		case ENTITY_TYPE_ENEMY_GRAPPLER:{ init_grappler(entity); } break;
-		case ENTITY_TYPE_ITEM_MISSILE:	{ init_item_missile(entity); } break;
-		case ENTITY_TYPE_ITEM_LIFEUP:	{ init_item_lifeup(entity); } break;
-		case ENTITY_TYPE_ITEM_LASER:	{ init_item_laser(entity); } break;
+		case ENTITY_TYPE_PLAYER:	{ init_player(es, ps, entity); } break;
+		case ENTITY_TYPE_BULLET:	{ init_bullet(es, entity); } break;
+		case ENTITY_TYPE_MISSILE:	{ init_missile(es, ps, entity); } break;
+		case ENTITY_TYPE_LASER:		{ init_laser(es, entity); } break;
+		case ENTITY_TYPE_ENEMY_DRIFTER: { init_drifter(es, entity); } break;
+		case ENTITY_TYPE_ENEMY_UFO:	{ init_ufo(es, entity); } break;
+		case ENTITY_TYPE_ENEMY_TRACKER: { init_tracker(es, ps, entity); } break;
+		case ENTITY_TYPE_ENEMY_TURRET:	{ init_turret(es, entity); } break;
+		case ENTITY_TYPE_ENEMY_GRAPPLER:{ init_grappler(es, entity); } break;
+		case ENTITY_TYPE_ITEM_MISSILE:	{ init_item_missile(es, entity); } break;
+		case ENTITY_TYPE_ITEM_LIFEUP:	{ init_item_lifeup(es, entity); } break;
+		case ENTITY_TYPE_ITEM_LASER:	{ init_item_laser(es, entity); } break;
 
 		case ENTITY_TYPE_SPAWN_WARP: {
 			entity->scale.x = entity->scale.y = 0;
 			entity->shape.radius = ENTITY_WARP_RADIUS;
 			entity->team = ENTITY_TEAM_UNDEFINED;
 			entity->color = SD_BLUE;
-			entity->flags = ENTITY_FLAG_COLLISION_DISABLED;
+			es->flags[result-1] = ENTITY_FLAG_COLLISION_DISABLED;
 		} break;
 
 		default : {} break;
 	}
 
-	return result;
+	return handle;
 }
 
 void random_item_spawn(Game_State* game, Vector2 position, float accumulation) {
 	game->score.item_accumulator += ITEM_ACCUMULATE_RATE * accumulation;
 
-	float roll = 5.0f + randomf() * 95.0f;
+	Random_Series* series = &game->entities->spawn_random;
+	float roll = 5.0f + random_float(series) * 95.0f;
 
 	if (roll < game->score.item_accumulator) {
-		float roll = randomf() * 100.0f;
+		float roll = random_float(series) * 100.0f;
 		if (roll > 55) {
 			spawn_entity(game->entities, game->particle_system, ENTITY_TYPE_ITEM_MISSILE, position);
 		} else {
@@ -271,7 +435,8 @@ void spawn_wave(Game_State* game, int wave, int points_max) {
 		{0  , 310, 390, 290},
 		{410, 330, 390, 290}
 	};
-	int zone_index = (randomf() * (array_length(spawn_zones))) - 1;
+	Random_Series* series = &game->entities->spawn_random;
+	int zone_index = (random_float(series) * (array_length(spawn_zones))) - 1;
 
 	//Add new enemy types every 5 waves
 	int type_value_max = ((float)wave / (float)WAVE_ESCALATION_RATE + 0.5f);
@@ -280,7 +445,7 @@ void spawn_wave(Game_State* game, int wave, int points_max) {
 	for (float points_remaining = (float)points_max; points_remaining > 0;) {
 		//Generate random type between 0 and current maximum point value
 		
-		Uint8 spawn_type = ENTITY_TYPE_ENEMY_DRIFTER + (int)(randomf() * (float)(type_value_max));// + 0.5f);
+		Uint8 spawn_type = ENTITY_TYPE_ENEMY_DRIFTER + (int)(random_float(series) * (float)(type_value_max));// + 0.5f);
 		float spawn_value = 1.0f + (float)(spawn_type - ENTITY_TYPE_ENEMY_DRIFTER);
 
 		if (spawn_value && points_remaining >= spawn_value) {
@@ -288,7 +453,7 @@ void spawn_wave(Game_State* game, int wave, int points_max) {
 			float entity_radius = 25;
 			Vector2 new_position = get_clear_spawn(game->entities, entity_radius, spawn_zones[zone_index]);
 			
-			Uint32 warp_id = spawn_entity(game->entities, game->particle_system, ENTITY_TYPE_SPAWN_WARP, new_position);
+			Entity_Handle warp_id = spawn_entity(game->entities, game->particle_system, ENTITY_TYPE_SPAWN_WARP, new_position);
 			if (warp_id){
 				Entity* warp = get_entity(game->entities, warp_id);
 				if (warp == NULL) { break; }
@@ -306,15 +471,16 @@ void remove_dead_entity(Game_State* game, Uint32 entity_id) {
 	Entity_System* es = game->entities;
 	Particle_System* ps = game->particle_system;
 
-	Entity* dead_entity = get_entity(es, entity_id);
-	if (dead_entity == NULL) { return; }
+	if (entity_id == 0 || entity_id > es->num_entities || es->states[entity_id-1] == ENTITY_STATE_UNDEFINED) { return; }
+	Entity* dead_entity = es->entities + (entity_id-1);
+	Vector2 position = es->positions[entity_id-1];
 	
 	for (int i = 0; i < dead_entity->emitter_count; i++) {
 		remove_particle_emitter(ps, dead_entity->particle_emitters[i]);
 	}
 	dead_entity->emitter_count = 0;
 
-	if (dead_entity->state == ENTITY_STATE_DYING) { // Skip for despawning entities
+	if (es->states[entity_id-1] == ENTITY_STATE_DYING) { // Skip for despawning entities
 		switch(dead_entity->type) {
 			case ENTITY_TYPE_PLAYER:	{ destroy_player(game); } break;
 			case ENTITY_TYPE_ENEMY_DRIFTER: { destroy_drifter(game, dead_entity); } break;
@@ -325,20 +491,20 @@ void remove_dead_entity(Game_State* game, Uint32 entity_id) {
 			float value = get_entity_score_value(dead_entity->type);
 			
 			add_score(game, value);
-			random_item_spawn(game, dead_entity->position, value);
+			random_item_spawn(game, position, value);
 			game->enemy_count--;
 
 			Mix_PlayChannel(-1, assets_get_sfx(game->assets, "Enemy Death"), 0);
 		}
 
-		if (dead_entity->flags & ENTITY_FLAG_EXPLOSION_ENABLED) {
+		if (es->flags[entity_id-1] & ENTITY_FLAG_EXPLOSION_ENABLED) {
 			RGBA_Color entity_color = (dead_entity->color.r || dead_entity->color.g || dead_entity->color.b) ? dead_entity->color : (RGBA_Color){255, 255, 255, 255};
 			RGBA_Color colors[] = {entity_color, {255, 255, 255, 255}};
 
-			force_circle(game->entities, dead_entity->x, dead_entity->y, ENEMY_EXPLOSION_RADIUS, 1.5f);
-			explode_at_point(ps, dead_entity->x, dead_entity->y, colors, array_length(colors), 0, dead_entity->shape.type);
+			force_circle(game->entities, position.x, position.y, ENEMY_EXPLOSION_RADIUS, 1.5f);
+			explode_at_point(ps, position.x, position.y, colors, array_length(colors), dead_entity->shape.type);
 			for (int sprite_index = 0; sprite_index < dead_entity->sprite_count; sprite_index++) {
-				explode_sprite(game->assets, ps, dead_entity->sprites+sprite_index, dead_entity->x, dead_entity->y, dead_entity->angle, 6);
+				explode_sprite(game->assets, ps, dead_entity->sprites+sprite_index, position.x, position.y, dead_entity->angle, ENTITY_EXPLOSION_PIECES);
 			}
 		}
 	}
@@ -346,32 +512,27 @@ void remove_dead_entity(Game_State* game, Uint32 entity_id) {
 	remove_entity(es, entity_id);
 }
 
-void on_enemy_collision(Entity* entity) {
+void on_enemy_collision(Entity_System* es, Entity* entity) {
 	// TODO: Make laser less obscenely overpowered.
 	// Original game used small circular hitbox to offset penetration effectiveness.
 	if (entity->type != ENTITY_TYPE_LASER) {
-		entity->state = ENTITY_STATE_DYING;
+		set_entity_state(es, entity, ENTITY_STATE_DYING);
 	}
 }
 
 void resolve_entity_collision(Game_State* game, Uint32 entity_index, Uint32 collision_entity_index) {
 	Entity_System* es = game->entities;
 
-	Entity* entity = get_entity(es, entity_index);
-	int valid = (
-		(entity != NULL)
-		&& (entity->state == ENTITY_STATE_ACTIVE)
-		&& !(entity->flags & ENTITY_FLAG_COLLISION_DISABLED)
-	);
-
-	Entity* collision_entity = get_entity(es, collision_entity_index);
-	valid = (valid 
-		&& (collision_entity != NULL)
-		&& (collision_entity->state == ENTITY_STATE_ACTIVE)
-		&& !(collision_entity->flags & ENTITY_FLAG_COLLISION_DISABLED)
-	);
+	// Both slots come from this tick's grid, so they are live and collidable,
+	// but either may have died to an earlier collision this tick
+	if (	es->states[entity_index-1] != ENTITY_STATE_ACTIVE
+		|| es->states[collision_entity_index-1] != ENTITY_STATE_ACTIVE
+	) { 
+		return; 
+	}
 
-	if (!valid) { return; }
+	Entity* entity = es->entities + (entity_index-1);
+	Entity* collision_entity = es->entities + (collision_entity_index-1);
 	
 	Vector2 overlap = {0};
 	Entity* item_entity = 	(entity_is_item(entity->type)) ? entity	 :
@@ -382,13 +543,9 @@ void resolve_entity_collision(Game_State* game, Uint32 entity_index, Uint32 coll
 				(collision_entity->type == ENTITY_TYPE_PLAYER) ? collision_entity :
 				0;
 	
-	if (check_shape_collision(
-		entity->transform, entity->shape, 
-		collision_entity->transform, collision_entity->shape,
-		&overlap)
-	) {
+	if (check_collider_collision(es->colliders + (entity_index-1), es->colliders + (collision_entity_index-1), &overlap)) {
 		if (item_entity && player_entity) {
-			item_entity->state = ENTITY_STATE_DESPAWNING;
+			set_entity_state(es, item_entity, ENTITY_STATE_DESPAWNING);
 			lerp_timer_start(&item_entity->timer, 0, ENTITY_WARP_DELAY/2.0f, -1);
 
 			switch (item_entity->type) {
@@ -412,36 +569,89 @@ void resolve_entity_collision(Game_State* game, Uint32 entity_index, Uint32 coll
 				} break;
 			}
 		} else if (entity->team && collision_entity->team && entity->team != collision_entity->team) {
-			on_enemy_collision(entity);
-			on_enemy_collision(collision_entity);
+			on_enemy_collision(es, entity);
+			on_enemy_collision(es, collision_entity);
 		} else if (
-			!((entity->flags|collision_entity->flags) & ENTITY_FLAG_COLLISION_TRIGGER)
+			!((es->flags[entity_index-1]|es->flags[collision_entity_index-1]) & ENTITY_FLAG_COLLISION_TRIGGER)
 		) {
 			overlap = normalize_vector2(overlap);
 
-			entity->vx		-= overlap.x/2.0f;
-			entity->vy		-= overlap.y/2.0f;
-			collision_entity->vx	+= overlap.x/2.0f;
-			collision_entity->vy	+= overlap.y/2.0f;
+			Vector2* velocity = es->velocities + (entity_index-1);
+			Vector2* collision_velocity = es->velocities + (collision_entity_index-1);
+			velocity->x		-= overlap.x/2.0f;
+			velocity->y		-= overlap.y/2.0f;
+			collision_velocity->x	+= overlap.x/2.0f;
+			collision_velocity->y	+= overlap.y/2.0f;
+		}
+	}
+}
+
+// Resolve every active entity's collider and bin the ones that can currently collide
+static void build_entity_grid(Game_State* game) {
+	Entity_System* es = game->entities;
+
+	reset_spatial_grid(es->grid, (Rectangle){0, 0, game->world_w, game->world_h});
+
+	for (int entity_index = 1; entity_index <= es->num_entities; entity_index++) {
+		if (es->states[entity_index-1] != ENTITY_STATE_ACTIVE) { continue; }
+
+		Collider* collider = es->colliders + (entity_index-1);
+		*collider = get_collider(get_entity_transform(es, es->entities + (entity_index-1)), es->entities[entity_index-1].shape);
+		
+		if (	collider->type == SHAPE_TYPE_UNDEFINED 
+			|| es->flags[entity_index-1] & ENTITY_FLAG_COLLISION_DISABLED
+		) {
+			continue;
+		}
+
+		spatial_grid_insert(es->grid, entity_index, collider->position, collider->radius + ENTITY_GRID_PADDING);
+	}
+}
+
+// Get ids after entity_id that may collide with it in es->candidates, in ascending order
+static int get_collision_candidates(Entity_System* es, Uint32 entity_id) {
+	Uint32* candidates = es->candidates;
+	Collider* collider = es->colliders + (entity_id-1);
+	int found_count = spatial_grid_query(es->grid, collider->position, collider->radius, candidates, es->capacity, true);
+
+	int result = 0;
+	for (int i = 0; i < found_count; i++) {
+		if (candidates[i] > entity_id) {
+			candidates[result++] = candidates[i];
 		}
 	}
+
+	return result;
 }
 
+// Entity updates run in three passes:
+// 1. State transitions and per-type logic, which may spawn or kill entities
+// 2. Integration, friction and wrapping over the hot arrays only
+// 3. Collision resolution and particle displacement against the post-move positions
 void update_entities(Game_State* game, float dt) {
 	Entity_System* es = game->entities;
 	Particle_System* ps = game->particle_system;
 	Entity* entity = 0;
 
+	// Only grow once freed slots have all been reused, so a pool that spiked doesn't keep doubling
+	if (es->grow_pending || (es->free_list == 0 && es->num_entities >= (Uint32)(es->capacity * ENTITY_POOL_GROW_THRESHOLD))) {
+		grow_entity_system(es, SDL_min(es->capacity * 2, ENTITY_HANDLE_INDEX_MASK));
+	}
+	es->locked = true;
+
+	Uint64 stage_start = SDL_GetPerformanceCounter();
+
 	for (int entity_index = 1; entity_index <= es->num_entities; entity_index++) {
-		entity = get_entity(game->entities, entity_index);
-		if (entity == NULL) { continue; }
+		if (es->states[entity_index-1] == ENTITY_STATE_UNDEFINED) { continue; }
+		entity = es->entities + (entity_index-1);
 		
 		lerp_timer_update(&entity->timer, dt);
-		if (entity->state == ENTITY_STATE_SPAWNING) {
+		Uint8 state = es->states[entity_index-1];
+		if (state == ENTITY_STATE_SPAWNING) {
 			if (entity->type == ENTITY_TYPE_PLAYER) {
 				update_spawning_player(game, entity, dt);
 			} else {
-				entity->transform.scale.x = entity->transform.scale.y = 1.0f - lerp_timer_get_t(&entity->timer);
+				entity->scale.x = entity->scale.y = 1.0f - lerp_timer_get_t(&entity->timer);
 						
 				if (entity->timer.time <= 0) {
 					switch(entity->type) {
@@ -452,21 +662,21 @@ void update_entities(Game_State* game, float dt) {
 							lerp_timer_start(&entity->timer, 0, 100, -1);
 						} break;
 					}
-					entity->state = ENTITY_STATE_ACTIVE;
+					es->states[entity_index-1] = ENTITY_STATE_ACTIVE;
 				}
 			}
 		// TODO: Movement update for despawning enemies
-		} else if (entity->state == ENTITY_STATE_DESPAWNING) {
-			entity->transform.scale.x = 
-				entity->transform.scale.y = 
+		} else if (state == ENTITY_STATE_DESPAWNING) {
+			entity->scale.x = 
+				entity->scale.y = 
 					lerp_timer_get_t(&entity->timer);
 
 			if (entity->timer.time <= 0) {
 				remove_dead_entity(game, entity_index);
 			}
-		} else if (entity->state == ENTITY_STATE_DYING) {
+		} else if (state == ENTITY_STATE_DYING) {
 			remove_dead_entity(game, entity_index);
-		} else if (entity->state == ENTITY_STATE_ACTIVE) {
+		} else if (state == ENTITY_STATE_ACTIVE) {
 			switch(entity->type) {
 				case ENTITY_TYPE_DEMOSHIP:	{ update_demo_ship(game, entity, dt); } break;
 				case ENTITY_TYPE_PLAYER:	{ update_player_entity(game, entity, dt); } break;
@@ -485,36 +695,63 @@ void update_entities(Game_State* game, float dt) {
 
 				case ENTITY_TYPE_SPAWN_WARP: {
 					lerp_timer_start(&entity->timer, 0, ENTITY_WARP_DELAY, -1);
-					entity->state = ENTITY_STATE_DESPAWNING;
+					es->states[entity_index-1] = ENTITY_STATE_DESPAWNING;
 					
-					Entity* spawn = get_entity(es, spawn_entity(es, ps, entity->type_data, entity->position));
+					Entity* spawn = get_entity(es, spawn_entity(es, ps, entity->type_data, es->positions[entity_index-1]));
 					if (spawn) {
-						spawn->transform.scale = (Vector2){0}; // Prevent drawing full size this frame
+						spawn->scale = (Vector2){0}; // Prevent drawing full size this frame
 					}
 				} break;
 			}
 
 			entity->angle = normalize_degrees(entity->angle);
-		
-			entity->x += entity->vx * dt;
-			entity->y += entity->vy * dt;
+		}
+	}
 
-			float friction = PHYSICS_FRICTION * (float)!(entity->flags & ENTITY_FLAG_FRICTION_DISABLED);
-			entity->vx *= 1.0 - (friction*dt);
-			entity->vy *= 1.0 - (friction*dt);
+	Uint64 stage_end = SDL_GetPerformanceCounter();
+	game->timings.entity_logic += stage_end - stage_start;
+	stage_start = stage_end;
 
-			entity->position = wrap_coords(entity->x, entity->y, 0, 0, game->world_w, game->world_h);
-		
-			// Entity-to-entity collision
-			if (!(entity->flags & ENTITY_FLAG_COLLISION_DISABLED)) {
-				for (int collision_entity_index = entity_index+1; collision_entity_index <= es->num_entities; collision_entity_index++) {
-					resolve_entity_collision(game, entity_index, collision_entity_index);
-				}
-			}
+	for (int i = 0; i < es->num_entities; i++) {
+		if (es->states[i] != ENTITY_STATE_ACTIVE) { continue; }
+
+		Vector2* position = es->positions + i;
+		Vector2* velocity = es->velocities + i;
+
+		position->x += velocity->x * dt;
+		position->y += velocity->y * dt;
+
+		float friction = PHYSICS_FRICTION * (float)!(es->flags[i] & ENTITY_FLAG_FRICTION_DISABLED);
+		velocity->x *= 1.0 - (friction*dt);
+		velocity->y *= 1.0 - (friction*dt);
+
+		*position = wrap_coords(position->x, position->y, 0, 0, game->world_w, game->world_h);
+	}
 
-			displace_particles(ps, entity->transform, scale_game_shape(entity->shape, entity->scale));
+	stage_end = SDL_GetPerformanceCounter();
+	game->timings.entity_physics += stage_end - stage_start;
+	stage_start = stage_end;
+
+	build_entity_grid(game);
+	update_particle_colliders(ps, (Rectangle){0, 0, game->world_w, game->world_h});
+
+	for (int entity_index = 1; entity_index <= es->num_entities; entity_index++) {
+		if (es->states[entity_index-1] != ENTITY_STATE_ACTIVE) { continue; }
+
+		// Entity-to-entity collision
+		if (!(es->flags[entity_index-1] & ENTITY_FLAG_COLLISION_DISABLED)) {
+			int candidate_count = get_collision_candidates(es, entity_index);
+			for (int i = 0; i < candidate_count; i++) {
+				resolve_entity_collision(game, entity_index, es->candidates[i]);
+				if (es->states[entity_index-1] != ENTITY_STATE_ACTIVE) { break; }
+			}
 		}
+
+		displace_particles(ps, es->colliders + (entity_index-1));
 	}
+
+	game->timings.entity_collision += SDL_GetPerformanceCounter() - stage_start;
+	es->locked = false;
 }
 
 Rectangle get_entity_bounding_box(Game_Assets* assets, Entity* entity) {
@@ -523,9 +760,9 @@ Rectangle get_entity_bounding_box(Game_Assets* assets, Entity* entity) {
 
 	if (entity->sprite_count > 0) {
 		shape.type = SHAPE_TYPE_RECT;
-		shape.rectangle = get_sprite_rect(assets, &entity->sprites[0]);
-		shape.rectangle.x -= shape.rectangle.w/2.0f;
-		shape.rectangle.y -= shape.rectangle.h/2.0f;
+		// Only the size, the sprite rect's position is where it sits on its atlas page
+		Rectangle sprite_rect = get_sprite_rect(assets, &entity->sprites[0]);
+		shape.rectangle = (Rectangle){-sprite_rect.w/2.0f, -sprite_rect.h/2.0f, sprite_rect.w, sprite_rect.h};
 
 		shape = rotate_game_shape(shape, entity->angle * (float)(int)(entity->sprites[0].rotation_enabled));
 	} else {
@@ -570,20 +807,19 @@ void draw_entities(Entity_System* es, Game_Assets* assets, int world_w, int worl
 	int wrap_count = 0;
 
 	for (int entity_index = 1; entity_index <= es->num_entities; entity_index++) {
-		entity = get_entity(es, entity_index);
-		if (entity == NULL
-		||  entity->state <= 0
-		||  entity->state >= ENTITY_STATE_DYING
-		||  entity->transform.scale.x+entity->transform.scale.y == 0
+		entity = es->entities + (entity_index-1);
+		if (es->states[entity_index-1] <= 0
+		||  es->states[entity_index-1] >= ENTITY_STATE_DYING
+		||  entity->scale.x+entity->scale.y == 0
 		) { continue; }
 
 		if (entity->type == ENTITY_TYPE_ENEMY_GRAPPLER) {
-			draw_grappler(entity);
+			draw_grappler(es, entity);
 		}
 
-		Transform2D transform = entity->transform;
+		Transform2D transform = get_entity_transform(es, entity);
 		Rectangle bounding_box = get_entity_bounding_box(assets, entity);
-		wrap_aab(entity->transform.position, bounding_box, world_rect, wrap_positions, &wrap_count);
+		wrap_aab(es->positions[entity_index-1], bounding_box, world_rect, wrap_positions, &wrap_count);
 
 		for (int i = 0; i < wrap_count; i++) {
 			transform.position = wrap_positions[i];
@@ -614,7 +850,7 @@ void draw_entities(Entity_System* es, Game_Assets* assets, int world_w, int worl
 					shape = rotate_game_shape(shape, entity->angle);
 
 		platform_set_render_draw_color((RGBA_Color){255, 0, 0, 255});
-		render_draw_game_shape(entity->position, shape, (RGBA_Color){255, 0, 0, 255});
+		render_draw_game_shape(es->positions[entity_index-1], shape, (RGBA_Color){255, 0, 0, 255});
 #endif
 	}
 }
@@ -47,13 +47,27 @@ typedef enum Entity_Flags {
 } Entity_Flags;
 
 
-Entity_System* create_entity_system();
+Entity_System* create_entity_system(Uint32 capacity, Uint64 seed);
 void reset_entity_system(Entity_System* es);
+Uint32 get_entity_count(Entity_System* es);
+Uint32 hash_entity_system(Entity_System* es, Uint32 hash);
+Random_Series* get_spawn_random(Entity_System* es);
 
-Uint32 get_new_entity(Entity_System* es);
-Entity* get_entity(Entity_System* es, Uint32 entity_id);
-Uint32 spawn_entity(Entity_System* es, Particle_System* ps, Entity_Types type, Vector2 position);
+Entity_Handle get_new_entity(Entity_System* es);
+Entity* get_entity(Entity_System* es, Entity_Handle handle);
+Entity_Handle get_entity_handle(Entity_System* es, Entity* entity);
+Entity_Handle spawn_entity(Entity_System* es, Particle_System* ps, Entity_Types type, Vector2 position);
+
+// Accessors for hot per-entity data
+Vector2* entity_position(Entity_System* es, Entity* entity);
+Vector2* entity_velocity(Entity_System* es, Entity* entity);
+Entity_States get_entity_state(Entity_System* es, Entity* entity);
+void set_entity_state(Entity_System* es, Entity* entity, Entity_States state);
+Uint32 get_entity_flags(Entity_System* es, Entity* entity);
+void set_entity_flags(Entity_System* es, Entity* entity, Uint32 flags);
+Transform2D get_entity_transform(Entity_System* es, Entity* entity);
 
 void force_circle(Entity_System* es, float x, float y, float radius, float force);
+void spawn_wave(Game_State* game, int wave, int points_max);
 
 #endif
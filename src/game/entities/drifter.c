@@ -6,24 +6,26 @@
 #define DRIFTER_RADIUS 40.0f
 #define DRIFTER_GREY (RGBA_Color){105, 105, 105, 255}
 
-static void generate_drifter_verts(Game_Shape* shape, float radius) {
-	int vert_count = SDL_clamp(5 + (int)(randomf() * 3.0f), 4, MAX_POLY2D_VERTS);
-	shape->polygon = generate_poly2D(vert_count, radius / 2.0f, radius);
+static void generate_drifter_verts(Random_Series* series, Game_Shape* shape, float radius) {
+	int vert_count = SDL_clamp(5 + (int)(random_float(series) * 3.0f), 4, MAX_POLY2D_VERTS);
+	shape->polygon = generate_poly2D(series, vert_count, radius / 2.0f, radius);
 	shape->type = SHAPE_TYPE_POLY2D;
 }
 
-static inline void init_drifter(Entity* entity) {
-	generate_drifter_verts(&entity->shape, DRIFTER_RADIUS);
+static inline void init_drifter(Entity_System* es, Entity* entity) {
+	generate_drifter_verts(&es->spawn_random, &entity->shape, DRIFTER_RADIUS);
 	entity->color = DRIFTER_GREY;
-	entity->angle = randomf() * 360.0f;
-	entity->velocity.x = cos_deg(entity->angle) * DRIFTER_SPEED;
-	entity->velocity.y = sin_deg(entity->angle) * DRIFTER_SPEED;
-	entity->flags = ENTITY_FLAG_EXPLOSION_ENABLED;
+	entity->angle = random_float(&es->spawn_random) * 360.0f;
+	Vector2* velocity = entity_velocity(es, entity);
+	velocity->x = cos_deg(entity->angle) * DRIFTER_SPEED;
+	velocity->y = sin_deg(entity->angle) * DRIFTER_SPEED;
+	set_entity_flags(es, entity, ENTITY_FLAG_EXPLOSION_ENABLED);
 }
 
 static inline void update_drifter(Game_State* game, Entity* entity, float dt) {
-	entity->velocity = scale_vector2(
-		normalize_vector2(entity->velocity),
+	Vector2* velocity = entity_velocity(game->entities, entity);
+	*velocity = scale_vector2(
+		normalize_vector2(*velocity),
 		DRIFTER_SPEED
 	);
 }
@@ -32,19 +34,10 @@ static inline void destroy_drifter(Game_State* game, Entity* entity) {
 	Entity_System* es = game->entities;
 	Particle_System* ps = game->particle_system;
 
-	float v_max = 0;
-	for (int i = 0; i < entity->shape.polygon.vert_count; i++) {
-		float v_dist = hypotf(
-			entity->shape.polygon.vertices[i].y,
-			entity->shape.polygon.vertices[i].x
-		);
-		v_max = SDL_max(v_dist, v_max);
-	}
-
-	if (v_max > DRIFTER_RADIUS/2) {
-		float angle = randomf() * 360.0f;
+	if (entity->shape.polygon.radius > DRIFTER_RADIUS/2) {
+		float angle = random_float(&es->spawn_random) * 360.0f;
 		for (int i = 0; i < 3; i++) {
-			Vector2 position = entity->position;
+			Vector2 position = *entity_position(es, entity);
 			position.x += cos_deg(angle) * (float)DRIFTER_RADIUS/2.0f;
 			position.y += sin_deg(angle) * (float)DRIFTER_RADIUS/2.0f;
 
@@ -55,11 +48,12 @@ static inline void destroy_drifter(Game_State* game, Entity* entity) {
 				);
 			if (drifter_child == NULL) { continue; }
 
-			generate_drifter_verts(&drifter_child->shape, (float)DRIFTER_RADIUS/2.0f);
+			generate_drifter_verts(&es->spawn_random, &drifter_child->shape, (float)DRIFTER_RADIUS/2.0f);
 			drifter_child->angle = angle;
-			drifter_child->vx = cos_deg(angle) * (float)DRIFTER_SPEED;
-			drifter_child->vy = sin_deg(angle) * (float)DRIFTER_SPEED;
-			drifter_child->state = ENTITY_STATE_ACTIVE;
+			Vector2* child_velocity = entity_velocity(es, drifter_child);
+			child_velocity->x = cos_deg(angle) * (float)DRIFTER_SPEED;
+			child_velocity->y = sin_deg(angle) * (float)DRIFTER_SPEED;
+			set_entity_state(es, drifter_child, ENTITY_STATE_ACTIVE);
 
 			angle += 360.0f / 3.0f;
 		}
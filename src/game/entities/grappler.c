@@ -22,24 +22,26 @@ typedef enum Grappler_State {
 	GRAPPLER_STATE_REELING,
 } Grappler_State;
 
-static inline void init_grappler(Entity* entity) {
+static inline void init_grappler(Entity_System* es, Entity* entity) {
 	entity->shape.radius = GRAPPLER_RADIUS;
 	entity->sprites[0].texture_name = "Enemy Grappler";
 	entity->sprites[0].rotation_enabled = 1;
 	entity->sprites[1].texture_name = "Grappler Hook";
 	entity->sprites[1].rotation_enabled = 1;
 	entity->sprite_count = 2;
-	entity->flags = ENTITY_FLAG_EXPLOSION_ENABLED;
+	set_entity_flags(es, entity, ENTITY_FLAG_EXPLOSION_ENABLED);
 }
 
 static inline void update_grappler(Game_State* game, Entity* entity, float dt) {
+	Entity_System* es = game->entities;
 	Entity* target = get_enemy_target(game);
+	Vector2 position = *entity_position(es, entity);
 
 	switch(entity->type_data) {
 		case GRAPPLER_STATE_AIMING: {
 			if (target) {
 				// TODO: Currently fires when target is directly behind as well
-				float aim_delta = angle_rotation_to_target(entity->position, target->position, entity->angle, GRAPPLER_AIM_TOLERANCE);
+				float aim_delta = angle_rotation_to_target(position, *entity_position(es, target), entity->angle, GRAPPLER_AIM_TOLERANCE);
 				if (aim_delta == 0) {
 					entity->type_data = GRAPPLER_STATE_EXTENDING;
 					Mix_PlayChannel(-1, assets_get_sfx(game->assets, "Grappler Fire"), 0);
@@ -53,18 +55,19 @@ static inline void update_grappler(Game_State* game, Entity* entity, float dt) {
 			entity->sprites[1].offset.x += GRAPPLER_HOOK_SPEED * dt;
 
 			Vector2 hook_position = rotate_vector2(entity->sprites[1].offset, entity->angle);
-			hook_position.x += entity->position.x;
-			hook_position.y += entity->position.y;
+			hook_position.x += position.x;
+			hook_position.y += position.y;
 
 			Vector2 overlap = {0};
 			if (	target && 
 				sc2d_check_circles(
 					hook_position.x, hook_position.y, (float)GRAPPLER_HOOK_RADIUS,
-					target->x, target->y, target->shape.radius,
+					entity_position(es, target)->x, entity_position(es, target)->y, target->shape.radius,
 					&overlap.x, &overlap.y
 				)
 			) {
 				entity->type_data = GRAPPLER_STATE_REELING;
+				entity->target = get_entity_handle(es, target);
 				Mix_PlayChannel(-1, assets_get_sfx(game->assets, "Hook Impact"), 0);
 
 			} else if (!sc2d_check_point_rect(
@@ -86,11 +89,11 @@ static inline void update_grappler(Game_State* game, Entity* entity, float dt) {
 		} break;
 
 		case GRAPPLER_STATE_REELING: {
-			if (target) {
-				Vector2 delta = {
-					target->x - entity->x,
-					target->y - entity->y
-				};
+			// Only reel in the entity that was hooked, not a respawned player
+			target = get_entity(es, entity->target);
+			if (target && get_entity_state(es, target) == ENTITY_STATE_ACTIVE) {
+				Vector2* target_velocity = entity_velocity(es, target);
+				Vector2 delta = subtract_vector2(*entity_position(es, target), position);
 				
 				float magnitude = SDL_sqrtf( (delta.x * delta.x) + (delta.y * delta.y));
 				delta = scale_vector2(delta, 1.0f/magnitude);
@@ -105,8 +108,8 @@ static inline void update_grappler(Game_State* game, Entity* entity, float dt) {
 					float angle_to_target = normalize_degrees( atan2_deg(delta.y, delta.x) );
 					entity->angle = angle_to_target;
 
-					target->vx -= delta.x * GRAPPLER_REELING_ACCELERATION * dt;
-					target->vy -= delta.y * GRAPPLER_REELING_ACCELERATION * dt;
+					target_velocity->x -= delta.x * GRAPPLER_REELING_ACCELERATION * dt;
+					target_velocity->y -= delta.y * GRAPPLER_REELING_ACCELERATION * dt;
 
 					entity->sprites[1].offset.x = magnitude;
 				} else {
@@ -120,13 +123,14 @@ static inline void update_grappler(Game_State* game, Entity* entity, float dt) {
 	}
 }
 
-static inline void draw_grappler(Entity* entity) {
+static inline void draw_grappler(Entity_System* es, Entity* entity) {
+	Vector2 position = *entity_position(es, entity);
 	Vector2 offset = {
 		.x = cos_deg(entity->angle+90.0f)*1.5f,
 		.y = sin_deg(entity->angle+90.0f)*1.5f
 	};
 	Vector2 end = add_vector2(
-		entity->position,
+		position,
 		rotate_vector2(
 			(Vector2){entity->sprites[1].offset.x-3, 0},
 			entity->angle
@@ -134,9 +138,9 @@ static inline void draw_grappler(Entity* entity) {
 	);
 
 	platform_set_render_draw_color(GRAPPLER_COLOR);
-	Vector2 line[2] = {add_vector2(entity->position, offset), add_vector2(end, offset)};
+	Vector2 line[2] = {add_vector2(position, offset), add_vector2(end, offset)};
 	platform_render_draw_lines(line, 2);
-	line[0] = subtract_vector2(entity->position, offset);
+	line[0] = subtract_vector2(position, offset);
 	line[1] = subtract_vector2(end, offset);
 	platform_render_draw_lines(line, 2);
 }
@@ -84,29 +84,29 @@ SDL_Texture* generate_laser_item_texture(void) {
 	return result;
 }
 
-static inline void init_item_missile(Entity* entity) {
+static inline void init_item_missile(Entity_System* es, Entity* entity) {
 	entity->team = ENTITY_TEAM_UNDEFINED;
 	entity->shape.radius = ITEM_RADIUS;
 	entity->sprites[0].texture_name = "Item Missile";
 	entity->sprites[0].rotation_enabled = 1;
 	entity->sprite_count = 1;
-	entity->flags = ENTITY_FLAG_COLLISION_TRIGGER;
+	set_entity_flags(es, entity, ENTITY_FLAG_COLLISION_TRIGGER);
 }
 
-static inline void init_item_lifeup(Entity* entity){
+static inline void init_item_lifeup(Entity_System* es, Entity* entity){
 	entity->team = ENTITY_TEAM_UNDEFINED;
 	entity->shape.radius = ITEM_RADIUS;
 	entity->sprites[0].texture_name = "Item LifeUp";
 	entity->sprites[0].rotation_enabled = 1;
 	entity->sprite_count = 1;
-	entity->flags = ENTITY_FLAG_COLLISION_TRIGGER;
+	set_entity_flags(es, entity, ENTITY_FLAG_COLLISION_TRIGGER);
 }
 
-static inline void init_item_laser(Entity* entity){
+static inline void init_item_laser(Entity_System* es, Entity* entity){
 	entity->team = ENTITY_TEAM_UNDEFINED;
 	entity->shape.radius = ITEM_RADIUS;
 	entity->sprites[0].texture_name = "Item Laser";
 	entity->sprites[0].rotation_enabled = 1;
 	entity->sprite_count = 1;
-	entity->flags = ENTITY_FLAG_COLLISION_TRIGGER;
+	set_entity_flags(es, entity, ENTITY_FLAG_COLLISION_TRIGGER);
 }
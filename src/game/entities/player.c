@@ -28,7 +28,7 @@
 #define PLAYER_LASER_HEAT 35.0f
 #define PLAYER_MISSILE_HEAT 45.0f
 
-static inline void init_player(Particle_System* ps, Entity* entity) {
+static inline void init_player(Entity_System* es, Particle_System* ps, Entity* entity) {
 	entity->team = ENTITY_TEAM_PLAYER;
 	entity->shape.radius = PLAYER_SHIP_RADIUS;
 	entity->angle = 270;
@@ -48,7 +48,7 @@ static inline void init_player(Particle_System* ps, Entity* entity) {
 			thruster->color_count = 1;
 		}
 	}
-	entity->flags = ENTITY_FLAG_EXPLOSION_ENABLED;
+	set_entity_flags(es, entity, ENTITY_FLAG_EXPLOSION_ENABLED);
 }
 
 static inline void destroy_player(Game_State* game) {
@@ -63,47 +63,50 @@ static inline void destroy_player(Game_State* game) {
 
 static inline void update_spawning_player(Game_State* game, Entity* entity, float dt) {
 	Particle_System* ps = game->particle_system;
-	float t = (entity->y - game->world_h) / (game->world_h/2.0f - game->world_h);
+	Vector2* position = entity_position(game->entities, entity);
+	float t = (position->y - game->world_h) / (game->world_h/2.0f - game->world_h);
 	float ts = sin_deg(t * 90.0f);
 
 	Particle_Emitter* thruster;
 	thruster = get_particle_emitter(ps, entity->particle_emitters[0]);
 	if (thruster) {
 		thruster->state = (entity->sx > 0.4f && entity->sx < 0.9f);
-		thruster->position = entity->position;
+		thruster->position = *position;
 		thruster->angle = normalize_degrees(entity->angle + 180.0f);
 	}
 
 	thruster = get_particle_emitter(ps, entity->particle_emitters[1]);
 	if (thruster) {
 		thruster->state = (entity->sx > 0.5f);
-		thruster->position = entity->position;
+		thruster->position = *position;
 		thruster->angle = normalize_degrees(entity->angle - 45);
 	}
 
 	thruster = get_particle_emitter(ps, entity->particle_emitters[2]);
 	if (thruster) {
 		thruster->state = (entity->sx > 0.5f);
-		thruster->position = entity->position;
+		thruster->position = *position;
 		thruster->angle = normalize_degrees(entity->angle + 45);
 	}
 
-	force_circle(game->entities, entity->x, entity->y, entity->sx * PLAYER_SHIP_RADIUS * 3.0f, 1.5f);
-	entity->y -= (8.0f - lerp(0.0f, 6.0f, t)) * dt;
+	force_circle(game->entities, position->x, position->y, entity->sx * PLAYER_SHIP_RADIUS * 3.0f, 1.5f);
+	position->y -= (8.0f - lerp(0.0f, 6.0f, t)) * dt;
 	entity->sx = entity->sy = t;
 	entity->shape.radius = ts * PLAYER_SHIP_RADIUS;
 
-	if (entity->y <= game->world_h/2.0f) {
-		entity->state = ENTITY_STATE_ACTIVE;
+	if (position->y <= game->world_h/2.0f) {
+		set_entity_state(game->entities, entity, ENTITY_STATE_ACTIVE);
 		entity->scale = (Vector2){1.0f, 1.0f};
 		entity->shape.radius = PLAYER_SHIP_RADIUS;
-		entity->velocity = (Vector2){0};
+		*entity_velocity(game->entities, entity) = (Vector2){0};
 		entity->timer = (Lerp_Timer){0};
 	}
 }
 
 static inline void update_player_entity(Game_State* game, Entity* entity, float dt) {
 	Game_Player_Controller controller = game->player_controller;
+	Vector2* position = entity_position(game->entities, entity);
+	Vector2* velocity = entity_velocity(game->entities, entity);
 
 	if (is_game_control_held(&game->input, &controller.turn_left))  
 		entity->angle -= PLAYER_TURN_SPEED * dt;
@@ -129,16 +132,16 @@ static inline void update_player_entity(Game_State* game, Entity* entity, float
 				float thrust_speed = (i > 0) ? PLAYER_LATERAL_THRUST : PLAYER_FORWARD_THRUST;
 
 				thruster->state = EMITTER_STATE_ACTIVE;
-				entity->vx += cos_deg(entity->angle + angle_offset) * thrust_speed * dt;
-				entity->vy += sin_deg(entity->angle + angle_offset) * thrust_speed * dt;
+				velocity->x += cos_deg(entity->angle + angle_offset) * thrust_speed * dt;
+				velocity->y += sin_deg(entity->angle + angle_offset) * thrust_speed * dt;
 				game->player_state.thrust_energy -= PLAYER_THRUST_CONSUMPTION *dt;
 			}
 		}
 
 		if (thruster->state == EMITTER_STATE_ACTIVE) {
 			thruster->angle = entity->angle + angle_offset + 180;
-			thruster->y = entity->y + sin_deg(thruster->angle) * (float)PLAYER_SHIP_RADIUS;
-			thruster->x = entity->x + cos_deg(thruster->angle) * (float)PLAYER_SHIP_RADIUS;
+			thruster->y = position->y + sin_deg(thruster->angle) * (float)PLAYER_SHIP_RADIUS;
+			thruster->x = position->x + cos_deg(thruster->angle) * (float)PLAYER_SHIP_RADIUS;
 		}
 
 		angle_offset -= 90.0f * (float)(i+1);
@@ -155,7 +158,7 @@ static inline void update_player_entity(Game_State* game, Entity* entity, float
 					case PLAYER_WEAPON_MG: {
 						game->player_state.weapon_heat += PLAYER_MG_HEAT;
 						Mix_PlayChannel(-1, assets_get_sfx(game->assets, "Player Shot"), 0);
-						Uint32 bullet_id = spawn_entity(game->entities, game->particle_system, ENTITY_TYPE_BULLET, entity->position);
+						Entity_Handle bullet_id = spawn_entity(game->entities, game->particle_system, ENTITY_TYPE_BULLET, *position);
 						Entity* bullet = get_entity(game->entities, bullet_id);
 						if (bullet == NULL) { break; }
 
@@ -165,11 +168,13 @@ static inline void update_player_entity(Game_State* game, Entity* entity, float
 							sin_deg(entity->angle)
 						};
 						
-						bullet->x += angle.x * PLAYER_SHIP_RADIUS;
-						bullet->y += angle.y * PLAYER_SHIP_RADIUS;
+						Vector2* bullet_position = entity_position(game->entities, bullet);
+						Vector2* bullet_velocity = entity_velocity(game->entities, bullet);
+						bullet_position->x += angle.x * PLAYER_SHIP_RADIUS;
+						bullet_position->y += angle.y * PLAYER_SHIP_RADIUS;
 						
-						bullet->vx = entity->vx + (angle.x * PLAYER_SHOT_SPEED);
-						bullet->vy = entity->vy + (angle.y * PLAYER_SHOT_SPEED);
+						bullet_velocity->x = velocity->x + (angle.x * PLAYER_SHOT_SPEED);
+						bullet_velocity->y = velocity->y + (angle.y * PLAYER_SHOT_SPEED);
 						bullet->color = SD_BLUE;
 						bullet->team = ENTITY_TEAM_PLAYER;
 						
@@ -189,18 +194,20 @@ static inline void update_player_entity(Game_State* game, Entity* entity, float
 						Vector2 angle = { cos_deg(entity->angle), sin_deg(entity->angle) };
 						
 						for (int i = 0; i < 2; i++) {
-							Uint32 missile_id = spawn_entity(game->entities, game->particle_system, ENTITY_TYPE_MISSILE, entity->position);
+							Entity_Handle missile_id = spawn_entity(game->entities, game->particle_system, ENTITY_TYPE_MISSILE, *position);
 							Entity* missile = get_entity(game->entities, missile_id);
 							if (missile == NULL) { break; }
 							
 							missile->timer.max /= 2.0f;
 
-							missile->x += cos_deg(entity->angle + position_offset) * PLAYER_SHIP_RADIUS;
-							missile->y += sin_deg(entity->angle + position_offset) * PLAYER_SHIP_RADIUS;
+							Vector2* missile_position = entity_position(game->entities, missile);
+							Vector2* missile_velocity = entity_velocity(game->entities, missile);
+							missile_position->x += cos_deg(entity->angle + position_offset) * PLAYER_SHIP_RADIUS;
+							missile_position->y += sin_deg(entity->angle + position_offset) * PLAYER_SHIP_RADIUS;
 							
 							missile->angle = entity->angle;
-							missile->vx = entity->vx + angle.x;
-							missile->vy = entity->vy + angle.y;
+							missile_velocity->x = velocity->x + angle.x;
+							missile_velocity->y = velocity->y + angle.y;
 							missile->team = ENTITY_TEAM_PLAYER;
 						
 							position_offset *= -1;
@@ -224,18 +231,20 @@ static inline void update_player_entity(Game_State* game, Entity* entity, float
 						Vector2 angle = { cos_deg(entity->angle), sin_deg(entity->angle) };
 						
 						for (int i = 0; i < 2; i++) {
-							Uint32 laser_id = spawn_entity(game->entities, game->particle_system, ENTITY_TYPE_LASER, entity->position);
+							Entity_Handle laser_id = spawn_entity(game->entities, game->particle_system, ENTITY_TYPE_LASER, *position);
 							Entity* laser = get_entity(game->entities, laser_id);
 							if (laser == NULL) { break; }
 
 							lerp_timer_start(&laser->timer, 0, 4, -1);
 							
-							laser->x += cos_deg(entity->angle + position_offset) * PLAYER_SHIP_RADIUS;
-							laser->y += sin_deg(entity->angle + position_offset) * PLAYER_SHIP_RADIUS;
+							Vector2* laser_position = entity_position(game->entities, laser);
+							Vector2* laser_velocity = entity_velocity(game->entities, laser);
+							laser_position->x += cos_deg(entity->angle + position_offset) * PLAYER_SHIP_RADIUS;
+							laser_position->y += sin_deg(entity->angle + position_offset) * PLAYER_SHIP_RADIUS;
 							
 							laser->angle = entity->angle;
-							laser->vx = entity->vx + angle.x * PLAYER_SHOT_SPEED * 2.0f;
-							laser->vy = entity->vy + angle.y * PLAYER_SHOT_SPEED * 2.0f;
+							laser_velocity->x = velocity->x + angle.x * PLAYER_SHOT_SPEED * 2.0f;
+							laser_velocity->y = velocity->y + angle.y * PLAYER_SHOT_SPEED * 2.0f;
 							laser->team = ENTITY_TEAM_PLAYER;
 						
 							position_offset *= -1;
@@ -259,14 +268,16 @@ static inline void update_demo_ship(Game_State* game, Entity* entity, float dt)
 	Particle_System* ps = game->particle_system;
 	float w = game->world_w / 2.0f;
 	float h = game->world_h / 2.0f;
+	Vector2* position = entity_position(game->entities, entity);
+	Vector2* velocity = entity_velocity(game->entities, entity);
 	Vector2 delta = {
-		entity->x - w,
-		entity->y - h,
+		position->x - w,
+		position->y - h,
 	};
 	float dist = SDL_sqrtf(delta.x*delta.x + delta.y*delta.y);
 	float vert = 1.2f - dist / SDL_sqrtf(w*w+h*h);
 
-	entity->transform.scale.x = entity->transform.scale.y = vert;
+	entity->scale.x = entity->scale.y = vert;
 	entity->shape.radius = 0;//vert * PLAYER_SHIP_RADIUS * 2;
 
 	if (entity->timer.time <= 0.0f) {
@@ -277,22 +288,22 @@ static inline void update_demo_ship(Game_State* game, Entity* entity, float dt)
 	entity->angle += (1 + ((float)entity->type_data * -2.0f)) * dt;
 
 	float v2 = vert*vert;
-	entity->vx += cos_deg(entity->angle) * v2 * dt;
-	entity->vy += sin_deg(entity->angle) * v2 * dt;
+	velocity->x += cos_deg(entity->angle) * v2 * dt;
+	velocity->y += sin_deg(entity->angle) * v2 * dt;
 
-	entity->vx *= 1.0f - 0.15f * dt;
-	entity->vy *= 1.0f - 0.15f * dt;
+	velocity->x *= 1.0f - 0.15f * dt;
+	velocity->y *= 1.0f - 0.15f * dt;
 
 	Particle_Emitter* thruster = get_particle_emitter(ps, entity->particle_emitters[0]);	
 	if (thruster) {
 		thruster->state = EMITTER_STATE_ACTIVE * (vert > 0.2);
-		thruster->position = entity->position;
+		thruster->position = *position;
 		thruster->speed = PLAYER_THRUST_PARTICLE_SPEED * vert;
 		thruster->scale.x = thruster->scale.y = vert;
 		thruster->angle = entity->angle - 180.0f;
 		thruster->position = (Vector2) {
-			entity->position.x + cos_deg(thruster->angle) * 16.0f * vert,
-			entity->position.y + sin_deg(thruster->angle) * 16.0f * vert,
+			position->x + cos_deg(thruster->angle) * 16.0f * vert,
+			position->y + sin_deg(thruster->angle) * 16.0f * vert,
 		};
 	}
 }
@@ -9,7 +9,7 @@
 #define TRACKER_PRECISION 0.1f
 #define TRACKER_COLLISION_RADIUS 14.0f
 
-static inline void init_tracker(Particle_System* ps, Entity* entity) {
+static inline void init_tracker(Entity_System* es, Particle_System* ps, Entity* entity) {
 	entity->shape.radius = TRACKER_COLLISION_RADIUS;
 	entity->sprites[0].texture_name = "Enemy Tracker";
 	entity->sprites[0].rotation_enabled = 1;
@@ -25,16 +25,18 @@ static inline void init_tracker(Particle_System* ps, Entity* entity) {
 		thruster->colors[0] = RED;
 		thruster->color_count = 1;
 	}
-	entity->flags = ENTITY_FLAG_EXPLOSION_ENABLED;
+	set_entity_flags(es, entity, ENTITY_FLAG_EXPLOSION_ENABLED);
 }
 
 static inline void update_tracker(Game_State* game, Entity* entity, float dt) {
+	Vector2* position = entity_position(game->entities, entity);
+	Vector2* velocity = entity_velocity(game->entities, entity);
 	Particle_Emitter* thruster = get_particle_emitter(game->particle_system, entity->particle_emitters[0]);
 	if (thruster) { thruster->state = 0; }
 	Entity* target = get_enemy_target(game);
 	if (target) {
 		float acceleration_speed = TRACKER_ACCEL/2.0f;
-		float aim_offset = angle_rotation_to_target(entity->position, target->position, entity->angle, TRACKER_PRECISION);
+		float aim_offset = angle_rotation_to_target(*position, *entity_position(game->entities, target), entity->angle, TRACKER_PRECISION);
 
 		if (aim_offset == 0) {
 			acceleration_speed *= 2;
@@ -42,15 +44,15 @@ static inline void update_tracker(Game_State* game, Entity* entity, float dt) {
 			if (thruster) {
 				thruster->state = 1;
 				thruster->angle = entity->angle + 180;
-				thruster->x = entity->x + cos_deg(thruster->angle);// * (entity->shape.radius + PARTICLE_MAX_START_RADIUS) / 2.0f;
-				thruster->y = entity->y + sin_deg(thruster->angle);// * (entity->shape.radius + PARTICLE_MAX_START_RADIUS) / 2.0f;
+				thruster->x = position->x + cos_deg(thruster->angle);// * (entity->shape.radius + PARTICLE_MAX_START_RADIUS) / 2.0f;
+				thruster->y = position->y + sin_deg(thruster->angle);// * (entity->shape.radius + PARTICLE_MAX_START_RADIUS) / 2.0f;
 			}
 		} else {
 			entity->angle += TRACKER_TURN_RATE * aim_offset * dt;
 		}
 
-		entity->vx += cos_deg(entity->angle) * acceleration_speed * dt;
-		entity->vy += sin_deg(entity->angle) * acceleration_speed * dt;
+		velocity->x += cos_deg(entity->angle) * acceleration_speed * dt;
+		velocity->y += sin_deg(entity->angle) * acceleration_speed * dt;
 	}
 
 }
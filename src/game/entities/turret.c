@@ -20,28 +20,29 @@ typedef enum Turret_State {
 	TURRET_STATE_RECOVERING,
 } Turret_State;
 
-static inline void init_turret(Entity* entity) {
+static inline void init_turret(Entity_System* es, Entity* entity) {
 	entity->shape.radius = TURRET_RADIUS;
 	entity->sprites[0].texture_name = "Enemy Turret Base";
 	entity->sprites[1].texture_name = "Enemy Turret Cannon";
 	entity->sprites[1].rotation_enabled = 1;
 	entity->sprite_count = 2;
-	entity->flags = ENTITY_FLAG_EXPLOSION_ENABLED;
+	set_entity_flags(es, entity, ENTITY_FLAG_EXPLOSION_ENABLED);
 }
 
 static inline void update_turret(Game_State* game, Entity* entity, float dt) {
 	Entity_System* es = game->entities;
 	Particle_System* ps = game->particle_system;
+	Vector2 turret_position = *entity_position(es, entity);
 
 	switch(entity->type_data) {
 		case TURRET_STATE_AIMING: {
 			Entity* target = get_enemy_target(game);
 			if (target) {
-				float aim_offset = angle_rotation_to_target(entity->position, target->position, entity->angle, TURRET_AIM_TOLERANCE);
+				float aim_offset = angle_rotation_to_target(turret_position, *entity_position(es, target), entity->angle, TURRET_AIM_TOLERANCE);
 				if (aim_offset == 0 && entity->timer.time <= 0) {
 					Vector2 position = {
-						entity->position.x + cos_deg(entity->angle) * TURRET_RADIUS,
-						entity->position.y + sin_deg(entity->angle) * TURRET_RADIUS
+						turret_position.x + cos_deg(entity->angle) * TURRET_RADIUS,
+						turret_position.y + sin_deg(entity->angle) * TURRET_RADIUS
 					};
 					
 					Vector2 velocity = {
@@ -51,13 +52,14 @@ static inline void update_turret(Game_State* game, Entity* entity, float dt) {
 					
 					float shot_offset_angle = normalize_degrees(entity->angle - 90.0f);
 					for (int i = 0; i < 2; i++) {
-						Uint32 new_shot_id = spawn_entity(es, ps, ENTITY_TYPE_BULLET, position);
+						Entity_Handle new_shot_id = spawn_entity(es, ps, ENTITY_TYPE_BULLET, position);
 						Entity* new_shot = get_entity(es, new_shot_id);
 						if (new_shot == NULL) { break; }
 
-						new_shot->x += cos_deg(shot_offset_angle) * TURRET_RADIUS;
-						new_shot->y += sin_deg(shot_offset_angle) * TURRET_RADIUS;
-						new_shot->velocity = velocity;
+						Vector2* shot_position = entity_position(es, new_shot);
+						shot_position->x += cos_deg(shot_offset_angle) * TURRET_RADIUS;
+						shot_position->y += sin_deg(shot_offset_angle) * TURRET_RADIUS;
+						*entity_velocity(es, new_shot) = velocity;
 						new_shot->shape.type = SHAPE_TYPE_CIRCLE;
 						new_shot->shape.radius = TURRET_SHOT_RADIUS;
 						lerp_timer_start(&new_shot->timer, 0, TURRET_SHOT_LIFE, -1);
@@ -8,15 +8,16 @@
 #define UFO_COLLISION_RADIUS 20.0f
 #define UFO_TURN_PRECISION 0.05f
 
-static inline void init_ufo(Entity* entity) {
+static inline void init_ufo(Entity_System* es, Entity* entity) {
 	entity->shape.radius = UFO_COLLISION_RADIUS;
-	entity->angle = entity->target_angle = randomf() * 360.0f;
+	entity->angle = entity->target_angle = random_float(&es->ai_random) * 360.0f;
 	entity->sprites[0].texture_name = "Enemy UFO";
 	entity->sprite_count = 1;
-	entity->flags = ENTITY_FLAG_EXPLOSION_ENABLED;
+	set_entity_flags(es, entity, ENTITY_FLAG_EXPLOSION_ENABLED);
 }
 
 static inline void update_ufo(Game_State* game, Entity* entity, float dt) {
+	Vector2* velocity = entity_velocity(game->entities, entity);
 	float angle_delta = 
 		(cos_deg(entity->target_angle) * sin_deg(entity->angle)) - 
 		(sin_deg(entity->target_angle) * cos_deg(entity->angle));
@@ -25,24 +26,24 @@ static inline void update_ufo(Game_State* game, Entity* entity, float dt) {
 		entity->timer.dir = 0;
 		entity->angle += dt * (float)(1 - ((int)(angle_delta < 0) * 2));
 
-		entity->vx += cos_deg(entity->angle) * UFO_SPEED * 0.025;
-		entity->vx += sin_deg(entity->angle) * UFO_SPEED * 0.025;
+		velocity->x += cos_deg(entity->angle) * UFO_SPEED * 0.025;
+		velocity->x += sin_deg(entity->angle) * UFO_SPEED * 0.025;
 	} else {
 		entity->timer.dir = -1;
 	}
 
 	if (entity->timer.time <= 0) {
-		entity->target_angle = randomf() * 360.0f;
+		entity->target_angle = random_float(&game->entities->ai_random) * 360.0f;
 		lerp_timer_start(&entity->timer, 0, UFO_DIR_CHANGE_DELAY, -1);
 	}
 
-	float magnitude = SDL_sqrt( (entity->vx * entity->vx) + (entity->vy * entity->vy) );
+	float magnitude = SDL_sqrt( (velocity->x * velocity->x) + (velocity->y * velocity->y) );
 
 	if (magnitude > UFO_SPEED) {
-		entity->vx *= 1 - 0.028 * dt;
-		entity->vy *= 1 - 0.028 * dt;
+		velocity->x *= 1 - 0.028 * dt;
+		velocity->y *= 1 - 0.028 * dt;
 	} else if (magnitude < UFO_SPEED - 0.05) {
-		entity->vx += cos_deg(entity->angle) * UFO_SPEED * 0.025;
-		entity->vy += sin_deg(entity->angle) * UFO_SPEED * 0.025;
+		velocity->x += cos_deg(entity->angle) * UFO_SPEED * 0.025;
+		velocity->y += sin_deg(entity->angle) * UFO_SPEED * 0.025;
 	}
 }
@@ -13,26 +13,26 @@
 #define MISSILE_ACCEL 0.2f
 #define MISSILE_TURN_RATE 3.0f
 
-static inline void init_bullet(Entity* entity) {
+static inline void init_bullet(Entity_System* es, Entity* entity) {
 	entity->shape.radius = PLAYER_SHOT_RADIUS;
-	entity->state = ENTITY_STATE_ACTIVE;
+	set_entity_state(es, entity, ENTITY_STATE_ACTIVE);
 	entity->color = (RGBA_Color){255, 150, 50, 255};
-	entity->flags = 
+	set_entity_flags(es, entity, 
 		ENTITY_FLAG_FRICTION_DISABLED
-		| ENTITY_FLAG_COLLISION_TRIGGER;
+		| ENTITY_FLAG_COLLISION_TRIGGER);
 }
 
-static inline void init_laser(Entity* entity) {
+static inline void init_laser(Entity_System* es, Entity* entity) {
 	entity->shape.type = SHAPE_TYPE_POLY2D;
 	Rectangle rect = {.x = -15, .w = 30, .y = -5, .h = 10,};
 	entity->shape.polygon = rect_to_poly2D(rect);
 	entity->color = SD_BLUE;
-	entity->flags = 
+	set_entity_flags(es, entity, 
 		ENTITY_FLAG_FRICTION_DISABLED
-		| ENTITY_FLAG_COLLISION_TRIGGER;
+		| ENTITY_FLAG_COLLISION_TRIGGER);
 }
 
-static inline void init_missile(Particle_System* ps, Entity* entity) {
+static inline void init_missile(Entity_System* es, Particle_System* ps, Entity* entity) {
 	entity->sprites[0] = (Game_Sprite){
 		.rotation_enabled = 1,
 		.texture_name = "Projectile Missile",
@@ -56,40 +56,52 @@ static inline void init_missile(Particle_System* ps, Entity* entity) {
 		thruster->density = 1.0f;
 	}
 
-	entity->flags =
+	set_entity_flags(es, entity,
 		ENTITY_FLAG_EXPLOSION_ENABLED
-		| ENTITY_FLAG_COLLISION_TRIGGER;
+		| ENTITY_FLAG_COLLISION_TRIGGER);
 }
 
 static inline void update_bullet(Game_State* game, Entity* entity, float dt) {
 	if (entity->timer.time <= 0) {
-		entity->state = ENTITY_STATE_DESPAWNING;
+		set_entity_state(game->entities, entity, ENTITY_STATE_DESPAWNING);
 		lerp_timer_start(&entity->timer, 0, BULLET_LIFETIME, -1);
 	}
 }
 
 static inline void update_missile(Game_State* game, Entity* entity, float dt) {
+	Entity_System* es = game->entities;
 	if (entity->timer.time <= 0) { 
-		entity->state = ENTITY_STATE_DYING;
+		set_entity_state(es, entity, ENTITY_STATE_DYING);
 		return;
 	}
 	
+	Vector2* position = entity_position(es, entity);
+	Vector2* velocity = entity_velocity(es, entity);
+
 	Particle_Emitter* thruster = get_particle_emitter(game->particle_system, entity->particle_emitters[0]);
 	thruster->state = 1;
-	thruster->position = entity->position;
+	thruster->position = *position;
 	thruster->angle = entity->angle + 180.0f;
 
 	Vector2 missile_direction = {
 		cos_deg(entity->angle), sin_deg(entity->angle)
 	};
 
-	Entity* target = 0;
-	{ // Acquire target
+	// Keep the cached target while it is alive and ahead of the missile
+	Entity* target = get_entity(es, entity->target);
+	if (target) {
+		Vector2 delta = normalize_vector2(subtract_vector2(*entity_position(es, target), *position));
+		if (dot_product_vector2(missile_direction, delta) <= 0.0f) {
+			target = 0;
+		}
+	}
+
+	if (target == NULL) { // Acquire target
 		int32_t nearest = 1.0;
 		Entity* potential_target = 0;
-		for (int i = 1; i <= game->entities->num_entities; i++) {
-			potential_target = get_entity(game->entities, i);
-			if (	potential_target == NULL ||
+		for (int i = 0; i < es->num_entities; i++) {
+			potential_target = es->entities + i;
+			if (	es->states[i] == ENTITY_STATE_UNDEFINED ||
 				potential_target == entity ||
 				potential_target->team == ENTITY_TEAM_UNDEFINED || 
 				potential_target->team == entity->team
@@ -98,8 +110,8 @@ static inline void update_missile(Game_State* game, Entity* entity, float dt) {
 			}
 
 			Vector2 delta = {
-				potential_target->x - entity->x,
-				potential_target->y - entity->y,
+				es->positions[i].x - position->x,
+				es->positions[i].y - position->y,
 			};
 			delta = normalize_vector2(delta);
 			
@@ -113,16 +125,20 @@ static inline void update_missile(Game_State* game, Entity* entity, float dt) {
 				}
 			}
 		}
+
+		entity->target = (target) ? get_entity_handle(es, target) : 0;
 	}
 
 	Vector2 delta = {0};
 
 	if (target) {
-		delta.x = (target->x + target->vx * dt) - entity->x;
-		delta.y = (target->y + target->vy * dt) - entity->y;
+		Vector2 target_position = *entity_position(es, target);
+		Vector2 target_velocity = *entity_velocity(es, target);
+		delta.x = (target_position.x + target_velocity.x * dt) - position->x;
+		delta.y = (target_position.y + target_velocity.y * dt) - position->y;
 		delta = normalize_vector2(delta);
 
-		float aim_offset = angle_rotation_to_target(entity->position, target->position, entity->angle, 0.0);
+		float aim_offset = angle_rotation_to_target(*position, target_position, entity->angle, 0.0);
 		entity->angle += aim_offset * MISSILE_TURN_RATE * dt;
 	}
 
@@ -131,6 +147,6 @@ static inline void update_missile(Game_State* game, Entity* entity, float dt) {
 		sin_deg(entity->angle) + delta.y
 	};
 	acceleration = scale_vector2(normalize_vector2(acceleration), MISSILE_ACCEL * dt);
-	entity->velocity = add_vector2(entity->velocity, acceleration);
+	*velocity = add_vector2(*velocity, acceleration);
 
 }
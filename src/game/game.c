@@ -23,6 +23,7 @@
 #define PAUSE_TRANSITION_TIME 15.0f
 #define STARTING_LIVES 3
 #define STAR_TWINKLE_INTERVAL 180.0f
+#define STARFIELD_RANDOM_STREAM 4
 
 static void spawn_player(Game_State* game) {
 	game->player = 
@@ -98,8 +99,22 @@ void load_game_assets(Game_State* game) {
 		"Item LifeUp"
 	);
 
-	// Additional settings for loaded assets	
+	// Additional settings for loaded assets. Texture mods are baked in when packed,
+	// since anything set on the atlas page afterwards would apply to every sprite on it.
 	SDL_SetTextureAlphaMod(assets_get_texture(game->assets, "Enemy UFO"), (Uint8)(255.0f * 0.7f));
+
+	assets_build_texture_atlas(game->assets, TEXTURE_ATLAS_PAGE_SIZE);
+
+	// Divide exploding sprites ahead of time so the first death doesn't have to
+	char* exploding_textures[] = {
+		"Player Ship", "Projectile Missile", "Grappler Hook", "Enemy Grappler",
+		"Enemy UFO", "Enemy Tracker", "Enemy Turret Base", "Enemy Turret Cannon",
+	};
+	for (int i = 0; i < array_length(exploding_textures); i++) {
+		Game_Sprite sprite = { .texture_name = exploding_textures[i] };
+		get_sprite_chunks(game->assets, &sprite, ENTITY_EXPLOSION_PIECES);
+	}
+
 	Mix_Chunk* c = 0;
 	while( !(c = assets_get_sfx(game->assets, "Player Laser")) ) {
 		_mm_pause();
@@ -112,20 +127,23 @@ void load_game_assets(Game_State* game) {
 	Mix_VolumeChunk(c, 64);
 }
 
-void init_game(Game_State* game) {
-	game->entities = create_entity_system();
+// entity_capacity is how many entities fit before the pool first grows, or 0 for INITIAL_ENTITY_CAPACITY
+void init_game(Game_State* game, Uint32 seed, Uint32 entity_capacity) {
+	game->entities = create_entity_system((entity_capacity) ? entity_capacity : INITIAL_ENTITY_CAPACITY, seed);
 
 	game->fit_world_to_screen = 1;
 	game->world_w = 800;
 	game->world_h = 600;
 
 	game->assets = new_game_assets();
-	game->particle_system = new_particle_system();
-	game->font = load_stbtt_font("assets/Orbitron-Regular.ttf", 64);
+	game->particle_system = new_particle_system(PARTICLE_CAPACITY, PARTICLE_EMITTER_CAPACITY, seed);
+	game->font = load_stbtt_sdf_font("assets/Orbitron-Regular.ttf", 32);
 
 	load_game_assets(game);
 
 	{ // Generate star field
+		Random_Series series;
+		seed_random_series(&series, seed, STARFIELD_RANDOM_STREAM);
 		int stars_per_row = 20;
 		int stars_per_column = STARFIELD_STAR_COUNT / stars_per_row;
 		Vector2 star_offset = {game->world_w / stars_per_row, game->world_h / stars_per_column};
@@ -135,15 +153,15 @@ void init_game(Game_State* game) {
 			for (int star_x = 0; star_x < stars_per_row; star_x++) {
 				int star_index = star_y * stars_per_row + star_x;
 				
-				game->starfield.positions[star_index].x = next_position.x + (deviation.x/2.0f) + (randomf() * deviation.x);
-				game->starfield.positions[star_index].y = next_position.y + (deviation.y/2.0f) + (randomf() * deviation.y);
+				game->starfield.positions[star_index].x = next_position.x + (deviation.x/2.0f) + (random_float(&series) * deviation.x);
+				game->starfield.positions[star_index].y = next_position.y + (deviation.y/2.0f) + (random_float(&series) * deviation.y);
 				
-				game->starfield.colors[star_index].r = 100 + (uint8_t)(randomf() * 155.0f);
-				game->starfield.colors[star_index].g = 100 + (uint8_t)(randomf() * 155.0f);
-				game->starfield.colors[star_index].b = 100 + (uint8_t)(randomf() * 155.0f);
+				game->starfield.colors[star_index].r = 100 + (uint8_t)(random_float(&series) * 155.0f);
+				game->starfield.colors[star_index].g = 100 + (uint8_t)(random_float(&series) * 155.0f);
+				game->starfield.colors[star_index].b = 100 + (uint8_t)(random_float(&series) * 155.0f);
 
-				game->starfield.timers[star_index] = randomf() * STAR_TWINKLE_INTERVAL;
-				game->starfield.twinkle_direction[star_index] = (randomf() > 0.5f);
+				game->starfield.timers[star_index] = random_float(&series) * STAR_TWINKLE_INTERVAL;
+				game->starfield.twinkle_direction[star_index] = (random_float(&series) > 0.5f);
 			
 				next_position.x += star_offset.x;
 			}
@@ -218,11 +236,11 @@ void restart_game(Game_State* game) {
 	spawn_player(game);
 #if DEBUG && 0
 	for (int i = ENTITY_TYPE_PLAYER+1; i < ENTITY_TYPE_SPAWN_WARP; i++) {
-		Uint32 entity_id = spawn_entity(
-			game->entities, game->particle_system, 
-			ENTITY_TYPE_SPAWN_WARP,
-			(Vector2){randomf() * (float)game->world_w, randomf() * (float)game->world_h}
-		);
+		// Initializer evaluation order is unspecified, so draw x and y in separate statements
+		Vector2 position;
+		position.x = random_float(get_spawn_random(game->entities)) * (float)game->world_w;
+		position.y = random_float(get_spawn_random(game->entities)) * (float)game->world_h;
+		Entity_Handle entity_id = spawn_entity(game->entities, game->particle_system, ENTITY_TYPE_SPAWN_WARP, position);
 		Entity* entity = get_entity(game->entities, entity_id);
 		if (entity) {
 			entity->type_data = i;
@@ -232,6 +250,17 @@ void restart_game(Game_State* game) {
 
 }
 
+// Checksum of the simulation state, used to check that input replays reproduce a session
+Uint32 get_game_checksum(Game_State* game) {
+	Uint32 result = HASH_BYTES_SEED;
+	result = hash_entity_system(game->entities, result);
+	result = hash_particle_system(game->particle_system, result);
+	result = hash_bytes(result, &game->score.total, sizeof(game->score.total));
+	result = hash_bytes(result, &game->scene, sizeof(game->scene));
+
+	return result;
+}
+
 int update_game(Game_State* game, Game_Input* input, float dt) {
 	int running = 1;
 	if (is_key_pressed(input, SDL_SCANCODE_ESCAPE)) {
@@ -325,7 +354,7 @@ int update_game(Game_State* game, Game_Input* input, float dt) {
 	} else {
 		switch(game->next_scene) {
 			case GAME_SCENE_MAIN_MENU: {
-				Uint32 warp_id = spawn_entity(
+				Entity_Handle warp_id = spawn_entity(
 					game->entities, game->particle_system, ENTITY_TYPE_SPAWN_WARP, (Vector2){game->world_w/2.0f, game->world_h});
 				Entity* demo_warp = get_entity(game->entities, warp_id);
 				if (demo_warp) {
@@ -361,19 +390,23 @@ int update_game(Game_State* game, Game_Input* input, float dt) {
 
 	if (game->scene != GAME_SCENE_PAUSED && game->next_scene != GAME_SCENE_PAUSED) {
 		update_entities(game, dt);
-		update_particles(game->particle_system, dt);
-		wrap_particles(
-			game->particle_system,
+
+		Uint64 particles_start = SDL_GetPerformanceCounter();
+		update_particles(
+			game->particle_system, dt,
 			(Rectangle){0,0, game->world_w, game->world_h}
 		);
+		game->timings.particles += SDL_GetPerformanceCounter() - particles_start;
 	}
 
 	// TODO: Implement better conditions for this.
 	// If there are as many dead entities as entities minus reserved 0 entity and player (if currently alive)
 	if (game->enemy_count == 0) {
+		Uint64 waves_start = SDL_GetPerformanceCounter();
 		game->score.current_wave++;
 		game->score.spawn_points_max++;
 		spawn_wave(game, game->score.current_wave, game->score.spawn_points_max);
+		game->timings.waves += SDL_GetPerformanceCounter() - waves_start;
 	}
 
 	return running;
@@ -392,7 +425,7 @@ void draw_game_world(Game_State* game) {
 		platform_render_draw_points(game->starfield.positions + star_index, 1);
 	}
 
-	draw_particles(game->particle_system, game->assets);
+	draw_particles(game->particle_system);
 	draw_entities(game->entities, game->assets, game->world_w, game->world_h);
 }
 
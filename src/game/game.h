@@ -3,8 +3,9 @@
 
 #include "game_types.h"
 
-void init_game(Game_State* game);
+void init_game(Game_State* game, Uint32 seed, Uint32 entity_capacity);
 int update_game(Game_State* game, Game_Input* input, float dt);
+Uint32 get_game_checksum(Game_State* game);
 void draw_game_world(Game_State* game);
 void draw_game_ui(Game_State* game);
 
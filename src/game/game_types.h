@@ -18,6 +18,9 @@
 #define TICK_RATE 60
 
 #define STARFIELD_STAR_COUNT 500
+#define INITIAL_ENTITY_CAPACITY 256
+#define PARTICLE_CAPACITY 512
+#define PARTICLE_EMITTER_CAPACITY 128
 typedef struct Game_Starfield {
 	Vector2 positions[STARFIELD_STAR_COUNT];
 	float timers[STARFIELD_STAR_COUNT];
@@ -52,11 +55,18 @@ typedef enum Player_Weapons {
 	PLAYER_WEAPON_LASER,
 } Player_Weapons;
 
+// Slot index in the low bits and a generation count in the high bits.
+// Handles to removed entities resolve to NULL even after their slot is reused.
+typedef Uint32 Entity_Handle;
+
+// Cold per-entity render and AI data.
+// Position, velocity, state and flags are stored in the Entity_System's hot arrays
+// and accessed through entity_position(), entity_velocity(), etc.
 typedef struct Entity {
-	Transform2D_Union;
+	Vec2_Union(scale, sx, sy);
+	float angle;
 	float z;
 	float target_angle;
-	Vec2_Union(velocity, vx, vy);
 	Lerp_Timer timer;
 
 	Game_Sprite sprites[4];
@@ -67,16 +77,25 @@ typedef struct Entity {
 
 	Uint32 particle_emitters[3];
 	Uint8 emitter_count;
+
+	Entity_Handle target; // The current homing or grapple target
 	
-	Uint32 flags;
 	Uint8 type;
-	Uint8 state;
 	Uint8 team;
 	Uint8 type_data;
 } Entity;
 
 typedef struct Entity_System Entity_System;
 
+// Performance counter ticks spent in each update stage, accumulated until cleared by the reader
+typedef struct Game_Timings {
+	Uint64 entity_logic;
+	Uint64 entity_physics;
+	Uint64 entity_collision;
+	Uint64 particles;
+	Uint64 waves;
+} Game_Timings;
+
 typedef enum Game_Scene {
 	GAME_SCENE_MAIN_MENU,
 	GAME_SCENE_GAMEPLAY,
@@ -115,13 +134,15 @@ typedef struct Game_State {
 	Lerp_Timer scene_timer;
 
 	Game_Player_Controller player_controller;
-	Uint32 player;
+	Entity_Handle player;
 	struct {
 		int lives;
 		int ammo;
 		float weapon_heat;
 		float thrust_energy;
 	} player_state;
+
+	Game_Timings timings;
 } Game_State;
 
 #endif
@@ -3,6 +3,7 @@
 #include "../engine/platform.h"
 #include "../engine/math.h"
 #include "../engine/assets.h"
+#include "../engine/particles.h"
 #include "../engine/ui.h"
 
 #include "game_types.h"
@@ -32,21 +33,21 @@ const char* get_weapon_label(Game_State* game) {
 }
 
 //TODO: Icon for "Unknown"
-SDL_Texture* get_weapon_icon(Game_State* game) {
-	SDL_Texture* result = 0;
+const char* get_weapon_icon(Game_State* game) {
+	const char* result = 0;
 	Entity* player = get_entity(game->entities, game->player);
 	if (player) {
 		switch (player->type_data) {
 			case PLAYER_WEAPON_MG: {
-				result = assets_get_texture(game->assets, "HUD MG");
+				result = "HUD MG";
 			} break;
 
 			case PLAYER_WEAPON_MISSILE: {
-				result = assets_get_texture(game->assets, "HUD Missile");
+				result = "HUD Missile";
 			} break;
 
 			case PLAYER_WEAPON_LASER: {
-				result = assets_get_texture(game->assets, "HUD Laser");
+				result = "HUD Laser";
 			} break;
 
 			default: {} break;
@@ -174,6 +175,7 @@ void draw_HUD(Game_State* game, Rectangle bounds, float scale, float t) {
 			.angle = -90,
 			.texture = {
 				.texture = assets_get_texture(game->assets, "Player Ship"),
+				.src = assets_get_texture_rect(game->assets, "Player Ship"),
 				.dest = {0,0,27,30},
 			},
 		},
@@ -249,6 +251,7 @@ void draw_HUD(Game_State* game, Rectangle bounds, float scale, float t) {
 	weapon_hud.x += (bounds.x+bounds.w);
 	weapon_hud.y += (bounds.y+bounds.h);
 
+	const char* weapon_icon = get_weapon_icon(game);
 	ui_element weapon_children[] = {
 		new_ui_text((Vector2){-60, -18}, 0, WHITE, "Ammo", 16, "center"),
 		new_ui_text((Vector2){-60, 18}, &(game->player_state.ammo), SD_BLUE, "", 36, "center"),
@@ -256,7 +259,10 @@ void draw_HUD(Game_State* game, Rectangle bounds, float scale, float t) {
 		{
 			.type = UI_TYPE_TEXTURE,
 			.pos = {40, 6},
-			.texture.texture = get_weapon_icon(game),
+			.texture = {
+				.texture = assets_get_texture(game->assets, weapon_icon),
+				.src = assets_get_texture_rect(game->assets, weapon_icon),
+			},
 		}
 	};
 	weapon_hud.children = weapon_children;
@@ -282,13 +288,15 @@ void draw_HUD(Game_State* game, Rectangle bounds, float scale, float t) {
 	char* labels[] = {
 		"Current Wave: ",
 		"Spawn Points Max: ",
-		"Spawn Type Max: "
+		"Spawn Type Max: ",
+		"Particle Budget %: ",
 	};
 	
 	int values[array_length(labels)] = {
 		game->score.current_wave,
 		game->score.spawn_points_max,
 		SDL_clamp((game->score.current_wave / WAVE_ESCALATION_RATE), 0, ENTITY_TYPE_ENEMY_GRAPPLER - ENTITY_TYPE_ENEMY_DRIFTER),
+		(int)(get_particle_budget_scale(game->particle_system) * 100.0f),
 	};
 
 	float font_size = 16.0f;
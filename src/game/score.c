@@ -28,10 +28,14 @@ void add_score(Game_State* game, float score_value) {
 
     int new_score = score->total + (int)(score_value * 100.0f * (float)score->multiplier);
     if (new_score / LIFE_UP_MILESTONE > score->total / LIFE_UP_MILESTONE) {
+	Random_Series* series = get_spawn_random(game->entities);
+	Vector2 position;
+	position.x = random_float(series) * game->world_w;
+	position.y = random_float(series) * game->world_h;
 	spawn_entity(
 	    game->entities, game->particle_system,
 	    ENTITY_TYPE_ITEM_LIFEUP,
-	    (Vector2){randomf() * game->world_w, randomf() * game->world_h}
+	    position
 	);
     }
     score->total = new_score;
@@ -1,7 +1,10 @@
 #include "SDL.h"
 #include "engine/platform.h"
+#include "engine/particles.h"
+#include "engine/math.h"
 #include "game/game.h"
 
+// Usage: sddx [--record file] [--workers count] [--entities capacity] [--deferred-rendering]
 int main(int argc, char* argv[]) {
 	Platform_State platform = {
 		.title = "Space Drifter DX",
@@ -9,19 +12,39 @@ int main(int argc, char* argv[]) {
 		.world = {800, 600},
 		.target_fps = (double)TARGET_FPS,
 		.target_frame_time = 1000.0/(double)TARGET_FPS,
+		.worker_count = 0, // The game's particle system is too small to split across threads
 	};
 	Game_State* game = SDL_calloc(1, sizeof(Game_State));
 	Game_Input input = {0};
 
+	Uint32 seed = (Uint32)SDL_GetPerformanceCounter();
+	Uint32 entity_capacity = 0;
+	for (int i = 1; i < argc; i++) {
+		if (SDL_strcmp(argv[i], "--deferred-rendering") == 0) {
+			platform.deferred_rendering = true;
+		} else if (i == argc - 1) {
+			break;
+		} else if (SDL_strcmp(argv[i], "--record") == 0) {
+			platform.input_recording = start_input_recording(argv[++i], seed);
+		} else if (SDL_strcmp(argv[i], "--workers") == 0) {
+			platform.worker_count = SDL_atoi(argv[++i]);
+		} else if (SDL_strcmp(argv[i], "--entities") == 0) {
+			entity_capacity = (Uint32)SDL_max(SDL_atoi(argv[++i]), 1);
+		}
+	}
+
 	platform_init(&platform);
-	init_game(game);
+	init_game(game, seed, entity_capacity);
+	set_particle_job_pool(game->particle_system, platform.jobs);
 
 	platform.current_count = platform.last_count = SDL_GetPerformanceCounter();
 
 	SDL_bool running;
 	while ( (running = platform_update_and_render(&platform, game, &input)) );
 
-	SDL_Quit();	
+	close_input_replay(platform.input_recording);
+	free_job_pool(platform.jobs);
+	SDL_Quit();
 
 	return 0;
 }
@@ -0,0 +1,512 @@
+#include "SDL.h"
+#include "engine/platform.h"
+#include "engine/particles.h"
+#include "engine/math.h"
+#include "game/game.h"
+#include "game/entities.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// Headless simulation for measuring update_game throughput.
+// Ticks as fast as possible with a scripted player, or with the input of a session
+// recorded by sddx --record, and reports counts and per-system timings.
+// Replays also check that every tick reproduces the recorded game state.
+//
+// Usage: sddx_sim [-t ticks] [-w starting wave] [-r report interval in ticks] [-s seed] [-j workers] [-c entity capacity]
+//        sddx_sim --replay file [-r report interval in ticks] [-j workers] [-c entity capacity]
+//        sddx_sim --bench-random [-s seed]
+//        sddx_sim --bench-particles [-t ticks] [-s seed] [-j workers] [-n live particles]
+//        sddx_sim --test-collisions [-s seed]
+
+#define SIM_DEFAULT_TICKS (TICK_RATE * 60 * 5)
+#define SIM_DEFAULT_REPORT_INTERVAL (TICK_RATE * 10)
+#define SIM_FIRE_INTERVAL 60 // Fire is briefly released so "pressed" controls still trigger
+#define SIM_RANDOM_VALUES 100000000
+#define SIM_RANDOM_BATCH 512
+#define SIM_BENCH_PARTICLES 480 // Live particles kept in the system by --bench-particles
+#define SIM_TEST_PAIRS 3000 // Pairs per shape type combination and placement checked by --test-collisions
+#define SIM_TEST_CIRCLE_VERTS 64 // Circles are this many sided polygons in the reference collision path
+#define SIM_TEST_TOLERANCE 0.004f // Allowed depth error as a fraction of the pair's combined radius
+
+typedef struct Sim_Options {
+	int ticks;
+	int wave;
+	int report_interval;
+	Uint32 seed;
+	int workers;
+	Uint32 bench_particle_count;
+	Uint32 entity_capacity; // 0 for the game's default
+	const char* replay_file;
+	SDL_bool bench_random;
+	SDL_bool bench_particles;
+	SDL_bool test_collisions;
+} Sim_Options;
+
+static Sim_Options parse_sim_options(int argc, char* argv[]) {
+	Sim_Options result = {
+		.ticks = SIM_DEFAULT_TICKS,
+		.wave = 0,
+		.report_interval = SIM_DEFAULT_REPORT_INTERVAL,
+		.seed = 1,
+		.workers = JOB_POOL_AUTO,
+		.bench_particle_count = SIM_BENCH_PARTICLES,
+	};
+
+	for (int i = 1; i < argc; i++) {
+		if (SDL_strcmp(argv[i], "--bench-random") == 0) {
+			result.bench_random = true;
+		} else if (SDL_strcmp(argv[i], "--bench-particles") == 0) {
+			result.bench_particles = true;
+		} else if (SDL_strcmp(argv[i], "--test-collisions") == 0) {
+			result.test_collisions = true;
+		} else if (i == argc - 1) {
+			break;
+		} else if (SDL_strcmp(argv[i], "-t") == 0) {
+			result.ticks = SDL_atoi(argv[++i]);
+		} else if (SDL_strcmp(argv[i], "-w") == 0) {
+			result.wave = SDL_atoi(argv[++i]);
+		} else if (SDL_strcmp(argv[i], "-r") == 0) {
+			result.report_interval = SDL_atoi(argv[++i]);
+		} else if (SDL_strcmp(argv[i], "-s") == 0) {
+			result.seed = (Uint32)SDL_strtoul(argv[++i], 0, 10);
+		} else if (SDL_strcmp(argv[i], "-j") == 0) {
+			result.workers = SDL_atoi(argv[++i]);
+		} else if (SDL_strcmp(argv[i], "-n") == 0) {
+			int count = SDL_atoi(argv[++i]);
+			result.bench_particle_count = (Uint32)SDL_max(count, 1);
+		} else if (SDL_strcmp(argv[i], "-c") == 0) {
+			int capacity = SDL_atoi(argv[++i]);
+			result.entity_capacity = (Uint32)SDL_max(capacity, 1);
+		} else if (SDL_strcmp(argv[i], "--replay") == 0) {
+			result.replay_file = argv[++i];
+		}
+	}
+
+	return result;
+}
+
+// Turn, thrust and fire constantly. Releasing fire once per interval lets the
+// menus advance and the player respawn.
+static void update_sim_input(Game_State* game, Game_Input* input, int tick) {
+	Game_Player_Controller* controller = &game->player_controller;
+	int fire_phase = tick % SIM_FIRE_INTERVAL;
+
+	input->keys[controller->fire.key] =
+		(fire_phase == 0) ? GAME_INPUT_PRESSED :
+		(fire_phase == SIM_FIRE_INTERVAL-1) ? GAME_INPUT_RELEASED :
+		GAME_INPUT_HELD;
+	input->keys[controller->thrust.key] = GAME_INPUT_HELD;
+	input->keys[controller->turn_left.key] = GAME_INPUT_HELD;
+}
+
+static double get_ms(Uint64 counter_ticks) {
+	return (double)counter_ticks / (double)SDL_GetPerformanceFrequency() * 1000.0;
+}
+
+// Compare the old rand()-based generator with Random_Series, one value at a time and batched
+static void bench_random(Sim_Options options) {
+	int count = SIM_RANDOM_VALUES;
+	float values[SIM_RANDOM_BATCH];
+	double sum = 0;
+
+	Uint64 start = SDL_GetPerformanceCounter();
+	for (int i = 0; i < count; i++) {
+		sum += (float)(rand() % 1000) / 1000.0f;
+	}
+	double rand_ms = get_ms(SDL_GetPerformanceCounter() - start);
+
+	Random_Series series;
+	seed_random_series(&series, options.seed, 0);
+	start = SDL_GetPerformanceCounter();
+	for (int i = 0; i < count; i++) {
+		sum += random_float(&series);
+	}
+	double series_ms = get_ms(SDL_GetPerformanceCounter() - start);
+
+	start = SDL_GetPerformanceCounter();
+	for (int i = 0; i < count; i += SIM_RANDOM_BATCH) {
+		fill_random_floats(&series, values, SIM_RANDOM_BATCH);
+		sum += values[i % SIM_RANDOM_BATCH];
+	}
+	double batch_ms = get_ms(SDL_GetPerformanceCounter() - start);
+
+	printf("%d values (checksum %.1f)\n", count, sum);
+	printf("%-20s %8.1f ms  %6.2f ns/value\n", "rand() % 1000", rand_ms, rand_ms * 1e6 / count);
+	printf("%-20s %8.1f ms  %6.2f ns/value\n", "random_float", series_ms, series_ms * 1e6 / count);
+	printf("%-20s %8.1f ms  %6.2f ns/value\n", "fill_random_floats", batch_ms, batch_ms * 1e6 / count);
+}
+
+// Time update_particles alone on a nearly full particle system, topping it up between ticks.
+// The final state hash is the same with any worker count.
+static void bench_particles(Sim_Options options) {
+	Uint32 capacity = SDL_max(PARTICLE_CAPACITY, options.bench_particle_count + PARTICLE_CAPACITY / 8);
+	Particle_System* ps = new_particle_system(capacity, PARTICLE_EMITTER_CAPACITY, options.seed);
+	Job_Pool* jobs = new_job_pool(options.workers);
+	set_particle_job_pool(ps, jobs);
+	Rectangle bounds = {0, 0, 800, 600};
+	Random_Series series;
+	seed_random_series(&series, options.seed, 0);
+
+	Uint64 update_time = 0;
+	double particles_updated = 0;
+	for (int tick = 0; tick < options.ticks; tick++) {
+		while (get_particle_count(ps) < options.bench_particle_count) {
+			float x = random_float(&series) * bounds.w;
+			float y = random_float(&series) * bounds.h;
+			explode_at_point(ps, x, y, 0, 0, SHAPE_TYPE_CIRCLE);
+		}
+
+		particles_updated += get_particle_count(ps);
+		Uint64 start = SDL_GetPerformanceCounter();
+		update_particles(ps, 1.0f, bounds);
+		update_time += SDL_GetPerformanceCounter() - start;
+	}
+
+	double ms = get_ms(update_time);
+	printf("%d ticks, %.0f particles updated in %.1f ms, %.0f particles/ms\n",
+		options.ticks, particles_updated, ms, particles_updated / ms);
+	printf("%d workers, particle state hash %08x\n", get_job_pool_workers(jobs), hash_particle_system(ps, 0));
+	free_job_pool(jobs);
+}
+
+// The collision path check_shape_collision replaced: every shape becomes a polygon, scaled and rotated
+// per call, and checked with SAT. Circles get SIM_TEST_CIRCLE_VERTS sides rather than the old 8 so the
+// reference is close to a true circle and the tolerances below can be tight.
+static int get_reference_polygon(Transform2D t, Game_Shape shape, Vector2* vertices) {
+	int result = 0;
+
+	switch(shape.type) {
+		case SHAPE_TYPE_POLY2D: {
+			for (result = 0; result < (int)shape.polygon.vert_count; result++) {
+				vertices[result] = shape.polygon.vertices[result];
+			}
+		} break;
+
+		case SHAPE_TYPE_RECT: {
+			Poly2D rect = rect_to_poly2D(shape.rectangle);
+			for (result = 0; result < (int)rect.vert_count; result++) {
+				vertices[result] = rect.vertices[result];
+			}
+		} break;
+
+		case SHAPE_TYPE_CIRCLE: {
+			for (result = 0; result < SIM_TEST_CIRCLE_VERTS; result++) {
+				float angle = 360.0f / (float)SIM_TEST_CIRCLE_VERTS * (float)result;
+				vertices[result] = (Vector2){cos_deg(angle) * shape.radius, sin_deg(angle) * shape.radius};
+			}
+		} break;
+
+		default: break;
+	}
+
+	for (int i = 0; i < result; i++) {
+		vertices[i] = rotate_vector2((Vector2){vertices[i].x * t.sx, vertices[i].y * t.sy}, t.angle);
+	}
+
+	return result;
+}
+
+static SDL_bool check_reference_collision(Transform2D t1, Game_Shape s1, Transform2D t2, Game_Shape s2, Vector2* overlap) {
+	Vector2 vertices1[SIM_TEST_CIRCLE_VERTS], vertices2[SIM_TEST_CIRCLE_VERTS];
+	int count1 = get_reference_polygon(t1, s1, vertices1);
+	int count2 = get_reference_polygon(t2, s2, vertices2);
+
+	*overlap = (Vector2){0};
+	SDL_bool result = sc2d_check_poly2d(
+		t1.x, t1.y, (float*)vertices1, count1,
+		t2.x, t2.y, (float*)vertices2, count2,
+		&overlap->x, &overlap->y
+	);
+
+	return result;
+}
+
+static Game_Shape random_test_shape(Random_Series* series, Game_Shape_Types type) {
+	Game_Shape result = {.type = type};
+
+	switch(type) {
+		case SHAPE_TYPE_CIRCLE: {
+			result.radius = 2.0f + random_float(series) * 38.0f;
+		} break;
+
+		case SHAPE_TYPE_RECT: {
+			float w = 4.0f + random_float(series) * 56.0f;
+			float h = 4.0f + random_float(series) * 56.0f;
+			result.rectangle = (Rectangle){-w / 2.0f, -h / 2.0f, w, h};
+		} break;
+
+		case SHAPE_TYPE_POLY2D: {
+			// Points in angle order on an ellipse make a convex polygon, and keeping the gaps under
+			// 180 degrees keeps the origin inside, which sc2d's axis projections assume
+			int count = 3 + (int)(random_u32(series) % (MAX_POLY2D_VERTS - 2));
+			float rx = 5.0f + random_float(series) * 35.0f;
+			float ry = 5.0f + random_float(series) * 35.0f;
+			float step = 360.0f / (float)count;
+			for (int i = 0; i < count; i++) {
+				float angle = step * ((float)i + (random_float(series) - 0.5f) * 0.4f);
+				result.polygon.vertices[i] = (Vector2){cos_deg(angle) * rx, sin_deg(angle) * ry};
+			}
+			result.polygon.vert_count = (Uint32)count;
+		} break;
+
+		default: break;
+	}
+
+	return result;
+}
+
+// Circles stay circles only under uniform scale, and unrotated rects take the rect/rect path
+static Transform2D random_test_transform(Random_Series* series, Game_Shape_Types type) {
+	Transform2D result = {0};
+	result.sx = 0.5f + random_float(series) * 1.5f;
+	result.sy = (type == SHAPE_TYPE_CIRCLE) ? result.sx : 0.5f + random_float(series) * 1.5f;
+	if (type != SHAPE_TYPE_CIRCLE && random_u32(series) % 2) {
+		result.angle = random_float(series) * 360.0f;
+	}
+
+	return result;
+}
+
+// Overlap the reference path still finds after moving the first shape back by overlap, 0 if they're apart
+static float get_reference_residual(Transform2D t1, Game_Shape s1, Transform2D t2, Game_Shape s2, Vector2 overlap) {
+	Vector2 remaining;
+	t1.position = subtract_vector2(t1.position, overlap);
+	float result = (check_reference_collision(t1, s1, t2, s2, &remaining)) ? vector2_length(remaining) : 0;
+	return result;
+}
+
+// Check check_shape_collision against the reference path for random pairs of every shape type
+// combination, placed grazing (just inside or just outside contact), deeply overlapping or anywhere
+// nearby. Returns the number of failures.
+//
+// Hit or miss must agree except within tolerance of contact. Where the reference's overlap pushes the
+// shapes apart it is the shortest push, so a shared hit must push them apart by the same depth, or be
+// along an axis they're nested on, where no push of that length could. Deep overlaps can leave the
+// reference short of separating them, and there the new depth must not be any shorter.
+static int test_collisions(Sim_Options options) {
+	enum { PLACE_GRAZING_INSIDE, PLACE_GRAZING_OUTSIDE, PLACE_DEEP, PLACE_ANY, PLACE_COUNT };
+	const char* placement_names[PLACE_COUNT] = {"grazing inside", "grazing outside", "deep", "any"};
+	const char* type_names[SHAPE_TYPE_COUNT] = {"", "circle", "rect", "poly"};
+
+	Random_Series series;
+	seed_random_series(&series, options.seed, 0);
+
+	int result = 0;
+	printf("%-14s %-16s %6s %6s %6s %9s %10s %8s\n", "shapes", "placement", "pairs", "hits", "nested", "ref short", "depth err", "failures");
+
+	for (int type1 = SHAPE_TYPE_CIRCLE; type1 < SHAPE_TYPE_COUNT; type1++) {
+		for (int type2 = SHAPE_TYPE_CIRCLE; type2 < SHAPE_TYPE_COUNT; type2++) {
+			for (int placement = 0; placement < PLACE_COUNT; placement++) {
+				int pairs = 0, hits = 0, nested = 0, unresolved_references = 0, failures = 0;
+				float worst_depth_error = 0;
+
+				for (int pair = 0; pair < SIM_TEST_PAIRS; pair++) {
+					Game_Shape s1 = random_test_shape(&series, type1);
+					Game_Shape s2 = random_test_shape(&series, type2);
+					Transform2D t1 = random_test_transform(&series, type1);
+					Transform2D t2 = random_test_transform(&series, type2);
+					t1.position = (Vector2){400.0f, 300.0f};
+
+					// Find where the reference shapes touch along a random direction
+					float size = get_collider(t1, s1).radius + get_collider(t2, s2).radius;
+					Vector2 direction = rotate_vector2((Vector2){1.0f, 0}, random_float(&series) * 360.0f);
+					float inside = 0, outside = size + 1.0f;
+					for (int i = 0; i < 32; i++) {
+						float distance = (inside + outside) / 2.0f;
+						Vector2 overlap;
+						t2.position = add_vector2(t1.position, scale_vector2(direction, distance));
+						if (check_reference_collision(t1, s1, t2, s2, &overlap)) inside = distance;
+						else outside = distance;
+					}
+
+					float tolerance = SIM_TEST_TOLERANCE * size + 0.01f;
+					float distance = inside;
+					switch(placement) {
+						case PLACE_GRAZING_INSIDE: distance -= tolerance * (1.5f + random_float(&series) * 3.5f); break;
+						case PLACE_GRAZING_OUTSIDE: distance += tolerance * (1.5f + random_float(&series) * 3.5f); break;
+						case PLACE_DEEP: distance *= 0.2f + random_float(&series) * 0.5f; break;
+						case PLACE_ANY: distance = random_float(&series) * (size + 1.0f); break;
+					}
+					if (distance <= 0) continue;
+					t2.position = add_vector2(t1.position, scale_vector2(direction, distance));
+
+					Vector2 expected = {0}, overlap = {0};
+					SDL_bool expected_hit = check_reference_collision(t1, s1, t2, s2, &expected);
+					SDL_bool hit = check_shape_collision(t1, s1, t2, s2, &overlap);
+					float expected_depth = (expected_hit) ? vector2_length(expected) : 0;
+					float depth = (hit) ? vector2_length(overlap) : 0;
+					pairs++;
+
+					const char* failure = 0;
+					if (hit != expected_hit) {
+						if (SDL_max(depth, expected_depth) > tolerance) failure = "hit disagrees";
+					} else if (hit) {
+						hits++;
+						SDL_bool separates = get_reference_residual(t1, s1, t2, s2, overlap) <= tolerance;
+						SDL_bool nested_along = !separates && get_reference_residual(t1, s1, t2, s2, scale_vector2(overlap, -1.0f)) > tolerance;
+						nested += nested_along;
+
+						if (get_reference_residual(t1, s1, t2, s2, expected) <= tolerance) {
+							float depth_error = SDL_fabsf(depth - expected_depth);
+							worst_depth_error = SDL_max(worst_depth_error, depth_error / size);
+							// The reference can fall up to tolerance short and still count as separating them
+							if (depth_error > tolerance * 2.0f) failure = "depth differs";
+							else if (!separates && !nested_along) failure = "overlap points the wrong way";
+						} else {
+							unresolved_references++;
+							if (depth < expected_depth - tolerance) failure = "depth is shorter";
+						}
+					}
+
+					if (failure) {
+						if (failures < 3) {
+							printf("FAIL %s/%s %s: %s, overlap (%.3f, %.3f) reference (%.3f, %.3f)\n",
+								type_names[type1], type_names[type2], placement_names[placement], failure,
+								overlap.x, overlap.y, expected.x, expected.y);
+						}
+						failures++;
+					}
+				}
+
+				char shapes[32];
+				SDL_snprintf(shapes, sizeof(shapes), "%s/%s", type_names[type1], type_names[type2]);
+				printf("%-14s %-16s %6d %6d %6d %9d %9.3f%% %8d\n", shapes, placement_names[placement],
+					pairs, hits, nested, unresolved_references, worst_depth_error * 100.0f, failures);
+				result += failures;
+			}
+		}
+	}
+
+	printf("%s: %d failures\n", (result) ? "FAILED" : "passed", result);
+
+	return result;
+}
+
+int main(int argc, char* argv[]) {
+	Sim_Options options = parse_sim_options(argc, argv);
+	if (options.bench_random) {
+		bench_random(options);
+		return 0;
+	} else if (options.bench_particles) {
+		bench_particles(options);
+		return 0;
+	} else if (options.test_collisions) {
+		return (test_collisions(options) == 0) ? 0 : 1;
+	}
+	Platform_State platform = {
+		.title = "Space Drifter DX Simulation",
+		.world = {800, 600},
+		.worker_count = options.workers,
+	};
+	Game_State* game = SDL_calloc(1, sizeof(Game_State));
+	Game_Input input = {0};
+
+	Input_Replay* replay = 0;
+	if (options.replay_file) {
+		replay = start_input_replay(options.replay_file);
+		if (replay == NULL) return 1;
+		options.seed = get_input_replay_seed(replay);
+	}
+
+	platform_init_headless(&platform);
+	init_game(game, options.seed, options.entity_capacity);
+	set_particle_job_pool(game->particle_system, platform.jobs);
+
+	Uint32 peak_entities = 0, peak_particles = 0;
+	Particle_Stats particle_totals = {0};
+	Uint32 peak_evicted = 0;
+	SDL_bool wave_started = (options.wave <= 0 || replay);
+	int ticks_run = 0;
+	int divergent_tick = 0;
+
+	Uint64 start = SDL_GetPerformanceCounter();
+	Uint64 report_start = start;
+	game->timings = (Game_Timings){0};
+	reset_collision_stats();
+
+	for (int tick = 1; replay || tick <= options.ticks; tick++) {
+		float dt = 1.0f;
+		Uint32 recorded_checksum = 0;
+
+		if (replay) {
+			if (!replay_input(replay, &input, &dt, &recorded_checksum)) break;
+		} else {
+			update_sim_input(game, &input, tick);
+			// Never reach game over, which would write to the score table
+			if (game->player_state.lives < 1) {
+				game->player_state.lives = 1;
+			}
+		}
+
+		update_game(game, &input, dt);
+		poll_input(&input);
+		ticks_run = tick;
+
+		end_particle_stats_frame(game->particle_system);
+		Particle_Stats particle_stats = get_particle_stats(game->particle_system);
+		particle_totals.particles_evicted += particle_stats.particles_evicted;
+		particle_totals.emitters_dropped += particle_stats.emitters_dropped;
+		peak_evicted = SDL_max(peak_evicted, particle_stats.particles_evicted);
+
+		if (replay && !divergent_tick && get_game_checksum(game) != recorded_checksum) {
+			divergent_tick = tick;
+			printf("replay diverged from the recording at tick %d\n", tick);
+		}
+
+		if (!wave_started && game->scene == GAME_SCENE_GAMEPLAY) {
+			game->score.current_wave = game->score.spawn_points_max = options.wave;
+			spawn_wave(game, options.wave, options.wave);
+			wave_started = true;
+		}
+
+		Uint32 entity_count = get_entity_count(game->entities);
+		Uint32 particle_count = get_particle_count(game->particle_system);
+		peak_entities = SDL_max(peak_entities, entity_count);
+		peak_particles = SDL_max(peak_particles, particle_count);
+
+		if (options.report_interval > 0 && tick % options.report_interval == 0) {
+			Uint64 now = SDL_GetPerformanceCounter();
+			printf("tick %7d  wave %3d  entities %5u  particles %4u  %9.0f ticks/s\n",
+				tick, game->score.current_wave, entity_count, particle_count,
+				(double)options.report_interval / (get_ms(now - report_start) / 1000.0));
+			report_start = now;
+		}
+	}
+
+	double total_ms = get_ms(SDL_GetPerformanceCounter() - start);
+	int ticks = SDL_max(ticks_run, 1);
+	printf("\n%d ticks in %.1f ms, %.0f ticks/s\n", ticks_run, total_ms, (double)ticks_run / (total_ms / 1000.0));
+	if (replay) {
+		if (divergent_tick) {
+			printf("replay diverged at tick %d\n", divergent_tick);
+		} else {
+			printf("replay matched the recording on every tick\n");
+		}
+	}
+	printf("peak entities %u, peak particles %u\n\n", peak_entities, peak_particles);
+
+	struct { const char* name; Uint64 time; } stages[] = {
+		{"entity logic", game->timings.entity_logic},
+		{"entity physics", game->timings.entity_physics},
+		{"entity collision", game->timings.entity_collision},
+		{"particles", game->timings.particles},
+		{"waves", game->timings.waves},
+	};
+	for (size_t i = 0; i < SDL_arraysize(stages); i++) {
+		double ms = get_ms(stages[i].time);
+		printf("%-18s %10.1f ms  %8.4f ms/tick  %5.1f%%\n", stages[i].name, ms, ms / (double)ticks, ms / total_ms * 100.0);
+	}
+
+	Collision_Stats collisions = get_collision_stats();
+	printf("\ncollision pairs %u, rejected by bounds %u, sent to SAT %u\n",
+		collisions.pairs_tested, collisions.pairs_rejected, collisions.pairs_sat);
+	printf("particles evicted %u (at most %u in a tick), emitters dropped %u\n",
+		particle_totals.particles_evicted, peak_evicted, particle_totals.emitters_dropped);
+
+	close_input_replay(replay);
+	free_job_pool(platform.jobs);
+	SDL_Quit();
+
+	return (divergent_tick) ? 2 : 0;
+}